@@ -0,0 +1,89 @@
+#include "DebugDraw.hpp"
+#include <raymath.h>
+#include <cmath>
+
+namespace cs381 {
+
+	DebugDraw::~DebugDraw() {
+		if (loaded) rlUnloadRenderBatch(batch);
+	}
+
+	DebugDraw& DebugDraw::Init(size_t maxLines) {
+		if (loaded) rlUnloadRenderBatch(batch);
+		batch = rlLoadRenderBatch(1, (int)((maxLines * 2 + 3) / 4));  // Sized in quads, 4 vertices each
+		loaded = true;
+		vertices.reserve(maxLines * 2);
+		return *this;
+	}
+
+	void DebugDraw::Line(Vector3 start, Vector3 end, Color color) {
+		if (!enabled) return;
+		vertices.push_back({ start, color });
+		vertices.push_back({ end, color });
+	}
+
+	// Corner i of a box has bit 0 set for max x, bit 1 for max y and bit 2 for max z, edges join corners one bit apart
+	constexpr int boxEdges[12][2] = {
+		{0, 1}, {2, 3}, {4, 5}, {6, 7},  // Along x
+		{0, 2}, {1, 3}, {4, 6}, {5, 7},  // Along y
+		{0, 4}, {1, 5}, {2, 6}, {3, 7},  // Along z
+	};
+
+	void DebugDraw::Box(const BoundingBox& box, Color color) {
+		Box(box, MatrixIdentity(), color);
+	}
+
+	void DebugDraw::Box(const BoundingBox& box, const Matrix& transform, Color color) {
+		if (!enabled) return;
+		Vector3 corners[8];
+		for (int i = 0; i < 8; ++i) {
+			Vector3 corner = { i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z };
+			corners[i] = Vector3Transform(corner, transform);
+		}
+		for (auto [a, b] : boxEdges) {
+			vertices.push_back({ corners[a], color });
+			vertices.push_back({ corners[b], color });
+		}
+	}
+
+	void DebugDraw::Sphere(Vector3 center, float radius, Color color, int segments) {
+		if (!enabled || segments < 3) return;
+		auto point = [&](int axis, int i) {
+			float angle = 2 * PI * i / segments, c = cosf(angle) * radius, s = sinf(angle) * radius;
+			switch (axis) {
+				case 0: return Vector3Add(center, { 0, c, s });
+				case 1: return Vector3Add(center, { c, 0, s });
+				default: return Vector3Add(center, { c, s, 0 });
+			}
+		};
+		for (int axis = 0; axis < 3; ++axis)
+			for (int i = 0; i < segments; ++i) {
+				vertices.push_back({ point(axis, i), color });
+				vertices.push_back({ point(axis, i + 1), color });
+			}
+	}
+
+	void DebugDraw::Axes(const Matrix& transform, float length) {
+		if (!enabled) return;
+		Vector3 origin = { transform.m12, transform.m13, transform.m14 };
+		Line(origin, Vector3Add(origin, Vector3Scale({ transform.m0, transform.m1, transform.m2 }, length)), RED);
+		Line(origin, Vector3Add(origin, Vector3Scale({ transform.m4, transform.m5, transform.m6 }, length)), GREEN);
+		Line(origin, Vector3Add(origin, Vector3Scale({ transform.m8, transform.m9, transform.m10 }, length)), BLUE);
+	}
+
+	void DebugDraw::Flush() {
+		lines = enabled && loaded ? vertices.size() / 2 : 0;
+		if (lines > 0) {
+			rlDrawRenderBatchActive();  // Whatever raylib queued so far goes first
+			rlSetRenderBatchActive(&batch);
+			rlBegin(RL_LINES);
+			for (auto& vertex : vertices) {
+				rlColor4ub(vertex.color.r, vertex.color.g, vertex.color.b, vertex.color.a);
+				rlVertex3f(vertex.position.x, vertex.position.y, vertex.position.z);
+			}
+			rlEnd();
+			rlSetRenderBatchActive(nullptr);  // Uploads and draws our batch, then switches back to raylib's
+		}
+		vertices.clear();
+	}
+}
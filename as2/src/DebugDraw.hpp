@@ -0,0 +1,46 @@
+#ifndef DEBUG_DRAW_HPP
+#define DEBUG_DRAW_HPP
+
+#include <raylib.h>
+#include <rlgl.h>
+#include <cstddef>
+#include <vector>
+
+namespace cs381 {
+
+	// Collects debug lines (boxes, spheres, axes...) during the frame and draws them all with one call in Flush
+	// raylib's DrawBoundingBox pushes a matrix and starts a new batch entry for every box, here shapes only append
+	// vertices to a CPU array, which Flush copies into a vertex buffer owned by this object (kept for the program's
+	// lifetime) and draws as a single GL_LINES draw
+	// Lines are depth tested like any other geometry, so Flush belongs inside BeginMode3D after the scene
+	struct DebugDraw {
+		bool enabled = true;  // Runtime toggle, while off shapes are dropped as they are added
+		size_t lines = 0;  // Drawn by the last Flush
+
+		DebugDraw() = default;
+		DebugDraw(const DebugDraw&) = delete;
+		~DebugDraw();
+
+		DebugDraw& Init(size_t maxLines = 1 << 17);  // Creates the vertex buffer, needs the window to exist. More lines than this still draw, in several calls
+
+		void Line(Vector3 start, Vector3 end, Color color);
+		void Box(const BoundingBox& box, Color color);
+		void Box(const BoundingBox& box, const Matrix& transform, Color color);  // Model space box, drawn oriented by transform
+		void Sphere(Vector3 center, float radius, Color color, int segments = 16);  // One circle around each axis
+		void Axes(const Matrix& transform, float length = 1);  // X red, Y green, Z blue, at transform's origin
+
+		void Flush();  // Draws and forgets everything added since the last Flush
+
+	protected:
+		struct Vertex {
+			Vector3 position;
+			Color color;
+		};
+
+		std::vector<Vertex> vertices;  // Two per line
+		rlRenderBatch batch = {};
+		bool loaded = false;
+	};
+}
+
+#endif // DEBUG_DRAW_HPP
@@ -1,20 +1,46 @@
 #include <iostream>
 #include <raylib-cpp.hpp>
 #include "skybox.hpp"
+#include "DebugDraw.hpp"
 
 template <typename T>
 concept Transformer = requires(T t, raylib::Matrix m) {
     { t(m) } -> std::convertible_to<raylib::Matrix>;
 };
 
-void DrawBoundedModel(raylib::Model& model, Transformer auto transformer) {
+// Model space bounds (ignoring model.transform), this walks every vertex so it is only done once per model at load
+BoundingBox MeshBounds(const raylib::Model& model) {
+    if (model.meshCount == 0) return { { 0, 0, 0 }, { 0, 0, 0 } };  // Nothing loaded, an empty box at the origin
+    BoundingBox bounds = GetMeshBoundingBox(model.meshes[0]);
+    for (int i = 1; i < model.meshCount; i++) {
+        BoundingBox mesh = GetMeshBoundingBox(model.meshes[i]);
+        bounds.min = Vector3Min(bounds.min, mesh.min);
+        bounds.max = Vector3Max(bounds.max, mesh.max);
+    }
+    return bounds;
+}
+
+// World space box around cached model space bounds, grows the transformed center by the absolute matrix
+BoundingBox TransformBounds(BoundingBox box, const Matrix& m) {
+    Vector3 center = Vector3Transform(Vector3Scale(Vector3Add(box.min, box.max), 0.5f), m);
+    Vector3 extent = Vector3Scale(Vector3Subtract(box.max, box.min), 0.5f);
+    Vector3 worldExtent = {
+        fabsf(m.m0) * extent.x + fabsf(m.m4) * extent.y + fabsf(m.m8) * extent.z,
+        fabsf(m.m1) * extent.x + fabsf(m.m5) * extent.y + fabsf(m.m9) * extent.z,
+        fabsf(m.m2) * extent.x + fabsf(m.m6) * extent.y + fabsf(m.m10) * extent.z
+    };
+    return { Vector3Subtract(center, worldExtent), Vector3Add(center, worldExtent) };
+}
+
+// The bounding box is only added to debug, which draws every box at once when flushed
+void DrawBoundedModel(cs381::DebugDraw& debug, raylib::Model& model, const BoundingBox& modelBounds, Transformer auto transformer) {
     raylib::Matrix backup = model.transform;  // Backup the current model transform
     model.transform = transformer(backup);    // Apply the transformation to the model
     model.Draw({});                           // Draw the model
 
     // Draw the bounding box based on the model's transformed state
-    BoundingBox bounds = model.GetBoundingBox();
-    DrawBoundingBox(bounds, WHITE);  // Use a visible color for the bounding box
+    BoundingBox bounds = TransformBounds(modelBounds, model.transform);
+    debug.Box(bounds, WHITE);  // Use a visible color for the bounding box
     model.transform = backup;     // Restore the original transformation
 }
 
@@ -31,38 +57,45 @@ int main() {
     auto car = raylib::Model("meshes/car.glb");
     car.transform = MatrixScale(30, 30, 30);
 
+    BoundingBox rocketBounds = MeshBounds(rocket);
+    BoundingBox carBounds = MeshBounds(car);
+
     cs381::SkyBox sky("textures/skybox.png");
+    cs381::DebugDraw debug;
+    debug.Init();
 
     InitAudioDevice();
     Music ambientMusic = LoadMusicStream("audio/sunflower.mp3");
     PlayMusicStream(ambientMusic);
 
     while(!window.ShouldClose()) {
+        if (IsKeyPressed(KEY_F1)) debug.enabled = !debug.enabled;
         window.BeginDrawing();
             camera.BeginMode();
                 window.ClearBackground(raylib::Color::Black());
                 sky.Draw();
 
-                DrawBoundedModel(rocket, [](raylib::Matrix transform) -> raylib::Matrix {
+                DrawBoundedModel(debug, rocket, rocketBounds, [](raylib::Matrix transform) -> raylib::Matrix {
                     return MatrixMultiply(transform, MatrixIdentity());
                 });
                 
-                DrawBoundedModel(rocket, [](raylib::Matrix transform) -> raylib::Matrix {
+                DrawBoundedModel(debug, rocket, rocketBounds, [](raylib::Matrix transform) -> raylib::Matrix {
                     return MatrixMultiply(MatrixMultiply(MatrixMultiply(MatrixScale(30, 30, 30), MatrixTranslate(-100, 100, 0)), MatrixScale(1, -1, 1)), MatrixRotateY(180));
                 });
                 
-                DrawBoundedModel(car, [](raylib::Matrix transform) -> raylib::Matrix {
+                DrawBoundedModel(debug, car, carBounds, [](raylib::Matrix transform) -> raylib::Matrix {
                     return MatrixMultiply(MatrixScale(30, 30, 30), MatrixTranslate(-200, 0, 0));
                 });
                 
-                DrawBoundedModel(car, [](raylib::Matrix transform) -> raylib::Matrix {
+                DrawBoundedModel(debug, car, carBounds, [](raylib::Matrix transform) -> raylib::Matrix {
                     return MatrixMultiply(MatrixMultiply(MatrixScale(30, 30, 30), MatrixTranslate(200, 0, 0)), MatrixRotateY(90));
                 });
                 
-                DrawBoundedModel(car, [](raylib::Matrix transform) -> raylib::Matrix {
+                DrawBoundedModel(debug, car, carBounds, [](raylib::Matrix transform) -> raylib::Matrix {
                     return MatrixMultiply(MatrixMultiply(MatrixMultiply(MatrixScale(30, 30, 30), MatrixTranslate(-100, -100, 0)), MatrixScale(1, 2, 1)), MatrixRotateY(270));
                 });
                 
+                debug.Flush();
 
             camera.EndMode();
         window.EndDrawing();
@@ -2,19 +2,36 @@
 #include <vector>
 #include <memory>  
 #include <optional>  
+#include <unordered_map>
 #include <algorithm> 
 #include <iostream>  
 #include "raylib-cpp.hpp" 
+#include "FixedTimestep.hpp"
 
 namespace cs381 {
 
     // Forward declare Entity, to be used later in Component
     struct Entity;
 
+    // Hands out the next free component type ID
+    inline size_t NextComponentTypeID() {
+        static size_t counter = 0;
+        return counter++;
+    }
+
+    // Small unique ID for each component type, used to index an entity's component slots
+    template <typename T>
+    size_t ComponentTypeID() {
+        static size_t id = NextComponentTypeID();
+        return id;
+    }
+
     // Component class definition (base class for all components)
     struct Component {
     protected:
         Entity* owner;  // Points to the Entity that owns this component
+        size_t typeID = -1;  // Set by Entity::AddComponent
+        friend struct Entity;
 
     public:
         // Constructor takes an Entity reference and sets the owner pointer
@@ -36,31 +53,78 @@ namespace cs381 {
     // Entity class that owns Components
     struct Entity {
         std::vector<std::unique_ptr<Component>> components;  // List of components
+        std::vector<Component*> slots;  // Lookup table indexed by ComponentTypeID, holds the first component of each type
 
         // Constructor that adds a TransformComponent by default
         Entity() {
             AddComponent<TransformComponent>();  // Ensures TransformComponent is always added
         }
 
+        Entity(const Entity&) = delete;
+        Entity(Entity&& other) : components(std::move(other.components)), slots(std::move(other.slots)) {
+            for (auto& component : components) {
+                component->owner = this;  // Components need to point at our new address
+            }
+        }
+
+        Entity& operator=(const Entity&) = delete;
+        Entity& operator=(Entity&& other) {
+            components = std::move(other.components);
+            slots = std::move(other.slots);
+            for (auto& component : components) {
+                component->owner = this;  // Components need to point at our new address
+            }
+            return *this;
+        }
+
         // Template function to add a component to the entity
         template <typename T, typename... Args>
         void AddComponent(Args&&... args) {
-            // Prevent adding multiple TransformComponent instances
-            if (std::none_of(components.begin(), components.end(), [](const auto& c) {
-                    return dynamic_cast<TransformComponent*>(c.get());
-                })) {
-                components.push_back(std::make_unique<T>(*this, std::forward<Args>(args)...));
-                std::cout << "Adding component: " << typeid(T).name() << std::endl;  // Prints the type of component added
+            size_t id = ComponentTypeID<T>();
+            if (slots.size() <= id) slots.resize(id + 1, nullptr);
+
+            // Entities keep their one TransformComponent, adding another sets its position and heading instead
+            if constexpr (std::is_same_v<T, TransformComponent>) {
+                if (slots[id]) {
+                    TransformComponent given(*this, std::forward<Args>(args)...);
+                    auto& transform = *static_cast<TransformComponent*>(slots[id]);
+                    transform.position = given.position;
+                    transform.heading = given.heading;
+                    return;
+                }
             }
+
+            components.push_back(std::make_unique<T>(*this, std::forward<Args>(args)...));
+            components.back()->typeID = id;
+            if (!slots[id]) slots[id] = components.back().get();  // Lookups find the first component of each type
+            std::cout << "Adding component: " << typeid(T).name() << std::endl;  // Prints the type of component added
+        }
+
+        // Template function to remove the component of a specific type (the one GetComponent would return)
+        template <typename T>
+        bool RemoveComponent() {
+            size_t id = ComponentTypeID<T>();
+            if (slots.size() <= id || !slots[id]) return false;
+
+            Component* removed = slots[id];
+            slots[id] = nullptr;
+            std::erase_if(components, [removed](const auto& c) { return c.get() == removed; });
+            for (auto& component : components) {  // A second component of the same type takes over the slot
+                if (component->typeID == id) {
+                    slots[id] = component.get();
+                    break;
+                }
+            }
+            return true;
         }
 
         // Template function to get a component of a specific type
+        // Only finds components whose type is exactly T, in exchange it is a single table lookup
         template <typename T>
         std::optional<std::reference_wrapper<T>> GetComponent() {
-            for (auto& component : components) {
-                if (auto casted = dynamic_cast<T*>(component.get())) {
-                    return *casted;  // Return the component if found
-                }
+            size_t id = ComponentTypeID<T>();
+            if (id < slots.size() && slots[id]) {
+                return *static_cast<T*>(slots[id]);  // Return the component if found
             }
             std::cerr << "Component of type " << typeid(T).name() << " not found!\n";  // Print error if component not found
             std::cerr << "Existing components: ";
@@ -110,18 +174,63 @@ namespace cs381 {
         }
     };
 
+    // Model space bounds of a model (ignoring model.transform), computed the first time each model is asked for
+    // GetBoundingBox walks every vertex, so entities sharing a model share one cached box
+    // Keyed by address, models must outlive the cache and not be reloaded in place (the old box would be returned)
+    inline const BoundingBox& CachedModelBounds(const raylib::Model* model) {
+        static std::unordered_map<const raylib::Model*, BoundingBox> cache;
+        auto [it, inserted] = cache.try_emplace(model);
+        if (inserted && model->meshCount == 0)
+            it->second = { { 0, 0, 0 }, { 0, 0, 0 } };  // Nothing loaded, an empty box at the origin
+        else if (inserted) {
+            BoundingBox& bounds = it->second = GetMeshBoundingBox(model->meshes[0]);
+            for (int i = 1; i < model->meshCount; i++) {
+                BoundingBox mesh = GetMeshBoundingBox(model->meshes[i]);
+                bounds.min = Vector3Min(bounds.min, mesh.min);
+                bounds.max = Vector3Max(bounds.max, mesh.max);
+            }
+        }
+        return it->second;
+    }
+
+    // World space box around model space bounds, grows the transformed center by the absolute matrix
+    inline BoundingBox TransformBounds(const BoundingBox& box, const Matrix& m) {
+        Vector3 center = Vector3Transform(Vector3Scale(Vector3Add(box.min, box.max), 0.5f), m);
+        Vector3 extent = Vector3Scale(Vector3Subtract(box.max, box.min), 0.5f);
+        Vector3 worldExtent = {
+            fabsf(m.m0) * extent.x + fabsf(m.m4) * extent.y + fabsf(m.m8) * extent.z,
+            fabsf(m.m1) * extent.x + fabsf(m.m5) * extent.y + fabsf(m.m9) * extent.z,
+            fabsf(m.m2) * extent.x + fabsf(m.m6) * extent.y + fabsf(m.m10) * extent.z
+        };
+        return { Vector3Subtract(center, worldExtent), Vector3Add(center, worldExtent) };
+    }
+
     // RenderComponent definition, handles drawing the entity's model
+    // It is drawn once per frame with Draw rather than from Update, which runs once per simulation tick
     struct RenderComponent : public Component {
         raylib::Model* model;  // Pointer to the model being rendered
+        raylib::Matrix worldTransform = raylib::Matrix::Identity();  // This entity's transform as of its last Draw
+        raylib::Vector3 previousPosition = {0, 0, 0};  // The transform before the last tick, Draw blends from it to the current one
+        float previousHeading = 0.0f;
 
         // Constructor to initialize the model
         RenderComponent(Entity& e, raylib::Model* m)
             : Component(e), model(m) {
+            CachedModelBounds(model);  // Compute the bounds now, at load, instead of on the first frame they are needed
+            StorePrevious();  // Nothing to blend from until the first tick
             std::cout << "RenderComponent added!" << std::endl;  // Print message when added
         }
 
-        // Update function to update the model's transformation and render it
-        void Update(float dt) override {
+        // Remembers the current transform, called before every tick
+        void StorePrevious() {
+            if (auto transformOpt = owner->GetComponent<TransformComponent>()) {
+                previousPosition = transformOpt.value().get().position;
+                previousHeading = transformOpt.value().get().heading;
+            }
+        }
+
+        // Renders the model alpha of the way from the previous tick's transform to the current one (see FixedTimestep::Alpha)
+        void Draw(float alpha) {
             // Ensure the entity has a TransformComponent before proceeding
             auto transformOpt = owner->GetComponent<TransformComponent>();
             if (!transformOpt.has_value()) {
@@ -130,29 +239,52 @@ namespace cs381 {
             }
 
             auto& transform = transformOpt.value().get();
+            raylib::Vector3 position = Vector3Lerp(previousPosition, transform.position, alpha);
+            float heading = LerpDegrees(previousHeading, transform.heading, alpha);
             std::cout << "Updating RenderComponent at position: "
-                      << transform.position.x << ", "
-                      << transform.position.y << ", "
-                      << transform.position.z << std::endl;  // Print position
+                      << position.x << ", "
+                      << position.y << ", "
+                      << position.z << std::endl;  // Print position
 
             // Update the model's transformation matrix based on the transform component
-            model->transform = raylib::Matrix::Identity()
-                .Translate(transform.position)  // Apply translation to position
-                .RotateY(raylib::Degree(transform.heading));  // Apply rotation based on heading
+            worldTransform = raylib::Matrix::Identity()
+                .Translate(position)  // Apply translation to position
+                .RotateY(raylib::Degree(heading));  // Apply rotation based on heading
+            model->transform = worldTransform;
 
             // Draw the model on screen
             model->Draw({});
         }
+
+        // The model is shared by several entities, so its transform only holds whichever entity drew last
+        BoundingBox WorldBounds() const { return TransformBounds(CachedModelBounds(model), worldTransform); }
     };
 
     // InputComponent definition, handles user input for controlling the entity
     struct InputComponent : public Component {
         float turnSpeed = 90.0f;  // Turning speed in degrees per second
         bool prevW = false, prevS = false, prevA = false, prevD = false;  // Flags for tracking key presses
+        bool pressedW = false, pressedS = false, pressedA = false, pressedD = false, pressedSpace = false;  // Presses Poll saw since the last Update
 
         // Constructor to initialize the input component
         InputComponent(Entity& e) : Component(e) {}
 
+        // Collects key presses, called every frame since a frame may run no ticks (its presses then wait for the next one)
+        void Poll() {
+            // Handle buffered input
+            pressedW |= IsKeyPressed(KEY_W) && !prevW;
+            pressedS |= IsKeyPressed(KEY_S) && !prevS;
+            pressedA |= IsKeyPressed(KEY_A) && !prevA;
+            pressedD |= IsKeyPressed(KEY_D) && !prevD;
+            pressedSpace |= IsKeyPressed(KEY_SPACE);
+
+            // Update previous key states for next frame
+            prevW = IsKeyDown(KEY_W);
+            prevS = IsKeyDown(KEY_S);
+            prevA = IsKeyDown(KEY_A);
+            prevD = IsKeyDown(KEY_D);
+        }
+
         // Update function to handle input and update the entity's movement
         void Update(float dt) override {
             // Ensure the entity has both TransformComponent and PhysicsComponent before proceeding
@@ -167,28 +299,23 @@ namespace cs381 {
             auto& transform = transformOpt.value().get();
             auto& physics = physicsOpt.value().get();
 
-            // Handle buffered input and update the speed/heading
-            if (IsKeyPressed(KEY_W) && !prevW) {
+            // Update the speed/heading from the presses Poll collected
+            if (pressedW) {
                 physics.speed += 2.0f * dt;  // Increase speed when 'W' is pressed
             }
-            if (IsKeyPressed(KEY_S) && !prevS) {
+            if (pressedS) {
                 physics.speed -= 2.0f * dt;  // Decrease speed when 'S' is pressed
             }
-            if (IsKeyPressed(KEY_A) && !prevA) {
+            if (pressedA) {
                 transform.heading += turnSpeed * dt;  // Turn left when 'A' is pressed
             }
-            if (IsKeyPressed(KEY_D) && !prevD) {
+            if (pressedD) {
                 transform.heading -= turnSpeed * dt;  // Turn right when 'D' is pressed
             }
 
-            // Update previous key states for next frame
-            prevW = IsKeyDown(KEY_W);
-            prevS = IsKeyDown(KEY_S);
-            prevA = IsKeyDown(KEY_A);
-            prevD = IsKeyDown(KEY_D);
-
             // Reset speed to 0 when spacebar is pressed
-            if (IsKeyPressed(KEY_SPACE)) physics.speed = 0;
+            if (pressedSpace) physics.speed = 0;
+            pressedW = pressedS = pressedA = pressedD = pressedSpace = false;
         }
     };
 
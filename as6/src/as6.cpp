@@ -3,6 +3,7 @@
 #include <raylib-cpp.hpp>
 #include "CO.hpp"
 #include "skybox.hpp"
+#include "DebugDraw.hpp"
 
 int main() {
     raylib::Window window(800, 600, "CS381 - Assignment 6");
@@ -52,21 +53,34 @@ int main() {
     entities.back().AddComponent<cs381::InputComponent>();
 
     cs381::SkyBox sky("textures/skybox.png");
+    cs381::DebugDraw debug;
+    debug.Init();
     raylib::Camera3D camera({0.0f, 10.0f, 30.0f}, {0, 0, 0}, {0.0f, 1.0f, 0.0f}, 45.0f, CAMERA_PERSPECTIVE);
 
     int selectedIndex = 0;
+    cs381::FixedTimestep timestep;  // Entities update in 60 Hz ticks whatever the frame rate (see FixedTimestep.hpp)
 
     while (!window.ShouldClose()) {
-        float deltaTime = window.GetFrameTime();
 
         // TAB Key to switch selection
         if (raylib::Keyboard::IsKeyPressed(KEY_TAB)) {
             selectedIndex = (selectedIndex + 1) % entities.size();
         }
+        // F1 to hide or show the bounding box
+        if (raylib::Keyboard::IsKeyPressed(KEY_F1)) {
+            debug.enabled = !debug.enabled;
+        }
 
-        // Update all entities
         for (auto& entity : entities) {
-            entity.Update(deltaTime);
+            if (auto input = entity.GetComponent<cs381::InputComponent>()) input->get().Poll();
+        }
+
+        // Update all entities, in as many ticks as the frame time covers
+        for (int steps = timestep.Advance(window.GetFrameTime()); steps > 0; --steps) {
+            for (auto& entity : entities) {
+                if (auto render = entity.GetComponent<cs381::RenderComponent>()) render->get().StorePrevious();
+                entity.Update(timestep.StepSize());
+            }
         }
 
         window.BeginDrawing();
@@ -75,16 +89,20 @@ int main() {
         camera.BeginMode();
         sky.Draw();
 
+        for (auto& entity : entities) {
+            if (auto render = entity.GetComponent<cs381::RenderComponent>()) render->get().Draw(timestep.Alpha());
+        }
         for (size_t i = 0; i < entities.size(); i++) {
             if (i == selectedIndex) {
                 // Ensure that the RenderComponent exists before drawing
                 if (auto renderCompOpt = entities[i].GetComponent<cs381::RenderComponent>()) {
                     auto& renderComp = renderCompOpt.value().get();
                     // Draw the bounding box for the selected entity
-                    DrawBoundingBox(renderComp.model->GetBoundingBox(), WHITE);
+                    debug.Box(renderComp.WorldBounds(), WHITE);
                 }
             }
         }
+        debug.Flush();
 
         camera.EndMode();
         window.EndDrawing();
@@ -6,14 +6,34 @@
 #include <memory>
 #include <vector>
 #include <optional>
+#include "Pool.hpp"
 
 namespace cs381 {
 
+	/**
+	 * @brief Hands out the next free component type ID.
+	 */
+	inline size_t NextComponentTypeID() {
+		static size_t counter = 0;
+		return counter++;
+	}
+
+	/**
+	 * @brief Small unique ID for each component type, used to index an entity's component slots.
+	 * @tparam T The component type.
+	 */
+	template<typename T>
+	size_t ComponentTypeID() {
+		static size_t id = NextComponentTypeID();
+		return id;
+	}
+
 	/**
 	 * @brief Base class for various components that can be attached to an entity.
 	 */
 	class Component {
 		struct Entity* object;
+		size_t typeID = -1; // Filled in by Entity::AddComponent
 		friend struct Entity;
 
 	public:
@@ -40,22 +60,98 @@ namespace cs381 {
 	};
 
 
+	/**
+	 * @brief Owns every component, grouped into one pool per concrete component type.
+	 * @note Ticking through the registry updates all components of one type before moving to the next, instead of
+	 * 	jumping between types entity by entity. Use Entity::Tick instead where per entity ordering matters.
+	 */
+	struct ComponentRegistry {
+		/**
+		 * @brief Type erased interface to a pool.
+		 */
+		struct PoolBase {
+			virtual ~PoolBase() {}
+			virtual void Tick(float dt) = 0;
+			virtual void Destroy(Component* component) = 0;
+		};
+
+		/**
+		 * @brief The components of exactly type T, kept in an ObjectPool so their addresses never change.
+		 */
+		template<std::derived_from<Component> T>
+		struct Pool: public PoolBase {
+			ObjectPool<T> objects;
+
+			template<typename... Ts>
+			T* Create(Ts&&... args) { return objects.Create(std::forward<Ts>(args)...); }
+
+			void Destroy(Component* component) override { objects.Destroy(static_cast<T*>(component)); }
+
+			void Tick(float dt) override {
+				objects.ForEach([dt](T& component) {
+					if(component.enabled)
+						component.T::Tick(dt); // Every component here is exactly a T, so the call can skip the vtable
+				});
+			}
+		};
+
+		std::vector<std::unique_ptr<PoolBase>> pools; // Indexed by ComponentTypeID
+
+		template<std::derived_from<Component> T>
+		Pool<T>& GetPool() {
+			size_t id = ComponentTypeID<T>();
+			if(pools.size() <= id) pools.resize(id + 1);
+			if(!pools[id]) pools[id] = std::make_unique<Pool<T>>();
+			return static_cast<Pool<T>&>(*pools[id]);
+		}
+
+		/**
+		 * @brief Ticks every enabled component, one type at a time (in the order types were first used).
+		 * @param dt The time elapsed since the last update.
+		 */
+		void Tick(float dt) {
+			for(auto& pool: pools)
+				if(pool) pool->Tick(dt);
+		}
+	};
+
+	/**
+	 * @brief The registry entities allocate their components from.
+	 */
+	inline ComponentRegistry& DefaultRegistry() {
+		static ComponentRegistry registry;
+		return registry;
+	}
+
+	/**
+	 * @brief Returns a component to the pool it came from.
+	 */
+	struct ComponentDeleter {
+		ComponentRegistry::PoolBase* pool = nullptr;
+		void operator()(Component* component) const { pool->Destroy(component); }
+	};
+
+
 	/**
 	 * @brief Represents an object in the game world.
 	 */
 	struct Entity {
-		std::vector<std::unique_ptr<Component>> components = {};
+		std::vector<std::unique_ptr<Component, ComponentDeleter>> components = {}; // Components are owned by their pool in DefaultRegistry
+		std::vector<Component*> slots = {}; // Component lookup table indexed by ComponentTypeID, holds the first component of each type
 
 		Entity() { AddComponent<TransformComponent>(); } // Entities have a transform by default!
 		Entity(const Entity&) = delete;
-		Entity(Entity&& other) : components(std::move(other.components)) {
+		Entity(Entity&& other) : components(std::move(other.components)), slots(std::move(other.slots)) {
 			for(auto& component: components)
 				component->object = this; // When we are moved make sure the components still point to us!
 		}
 
+		bool operator==(const Entity& other) const { return this == &other; } // Entities own their components, so every one is unique
+
 		Entity& operator=(const Entity&) = delete;
 		Entity& operator=(Entity&& other) {
 			components = std::move(other.components);
+			slots = std::move(other.slots);
 			for(auto& component: components)
 				component->object = this; // When we are moved make sure the components still point to us!
 			return *this;
@@ -64,6 +160,7 @@ namespace cs381 {
 		/**
 		 * @brief Performs actions during each game update for the entity and its components.
 		 * @param dt The time elapsed since the last update.
+		 * @note Ticks this entity's components in the order they were added, DefaultRegistry().Tick is faster for whole worlds.
 		 */
 		void Tick(float dt) {
 			for(auto& componentPtr: components)
@@ -80,30 +177,47 @@ namespace cs381 {
 		 */
 		template<std::derived_from<Component> T, typename... Ts>
 		size_t AddComponent(Ts... args) {
-			std::unique_ptr<Component> component = std::make_unique<T>(*this, std::forward<Ts>(args) ...);
+			auto& pool = DefaultRegistry().GetPool<T>();
+			std::unique_ptr<Component, ComponentDeleter> component(pool.Create(*this, std::forward<Ts>(args) ...), ComponentDeleter{&pool});
+			size_t id = component->typeID = ComponentTypeID<T>();
+			if(slots.size() <= id) slots.resize(id + 1, nullptr);
+			if(!slots[id]) slots[id] = component.get(); // Lookups find the first component of each type
 			components.push_back(std::move(component));
 			return components.size() - 1;
 		}
 
-		// How could we remove a component?
+		/**
+		 * @brief Removes the component of type T from the entity (the one GetComponent<T> would return).
+		 * @tparam T The type of component to remove.
+		 * @return True if a component was removed.
+		 */
+		template<std::derived_from<Component> T>
+		bool RemoveComponent() {
+			size_t id = ComponentTypeID<T>();
+			if(slots.size() <= id || !slots[id]) return false;
+
+			Component* removed = slots[id];
+			slots[id] = nullptr;
+			std::erase_if(components, [removed](auto& component) { return component.get() == removed; });
+			for(auto& component: components) // If there was a second component of the same type it now fills the slot
+				if(component->typeID == id) {
+					slots[id] = component.get();
+					break;
+				}
+			return true;
+		}
 
 		/**
 		 * @brief Retrieves a component of type T from the entity.
 		 * @tparam T The type of component to retrieve.
 		 * @return An optional reference to the component if found, or std::nullopt if not found.
+		 * @note Only finds components whose type is exactly T (no base class lookups), in exchange it is a single table lookup.
 		 */
 		template<std::derived_from<Component> T>
 		std::optional<std::reference_wrapper<T>> GetComponent() {
-			if constexpr(std::is_same_v<T, TransformComponent>){ // This extra step here allows us to skip itterator overhead since we know the transform component should be in slot 0
-				T* cast = dynamic_cast<T*>(components[0].get());
-				if(cast) return *cast;
-			}
-
-			for(auto& componentPtr: components){
-				T* cast = dynamic_cast<T*>(componentPtr.get());
-				if(cast) return *cast;
-			}
-
+			size_t id = ComponentTypeID<T>();
+			if(id < slots.size() && slots[id])
+				return *static_cast<T*>(slots[id]);
 			return {};
 		}
 
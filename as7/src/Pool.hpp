@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace cs381 {
+
+	/**
+	 * @brief Stores objects of exactly type T in fixed size chunks, so their addresses never change.
+	 * @note Freed slots are reused before a new chunk is added. Objects still alive when the pool is destroyed are destroyed with it.
+	 */
+	template<typename T>
+	struct ObjectPool {
+		static constexpr size_t ChunkSize = 64;
+		struct Slot {
+			alignas(T) std::byte storage[sizeof(T)];
+			bool live = false;
+			T& Get() { return *std::launder(reinterpret_cast<T*>(storage)); }
+		};
+		using Chunk = std::array<Slot, ChunkSize>;
+
+		std::vector<std::unique_ptr<Chunk>> chunks;
+		std::vector<Slot*> freeSlots;
+
+		ObjectPool() = default;
+		ObjectPool(const ObjectPool&) = delete;
+		~ObjectPool() {
+			for(auto& chunk: chunks)
+				for(auto& slot: *chunk)
+					if(slot.live) slot.Get().~T();
+		}
+
+		template<typename... Ts>
+		T* Create(Ts&&... args) {
+			if(freeSlots.empty()) { // Out of space, add a chunk
+				chunks.push_back(std::make_unique<Chunk>());
+				for(size_t i = ChunkSize; i--; ) // Reverse so slots are handed out front to back
+					freeSlots.push_back(&(*chunks.back())[i]);
+			}
+			Slot* slot = freeSlots.back();
+			T* object = new(slot->storage) T(std::forward<Ts>(args)...);
+			freeSlots.pop_back();
+			slot->live = true;
+			return object;
+		}
+
+		void Destroy(T* object) {
+			static_assert(std::is_standard_layout_v<Slot> && offsetof(Slot, storage) == 0, "The object's address must be its slot's address");
+			Slot* slot = reinterpret_cast<Slot*>(object);
+			slot->Get().~T();
+			slot->live = false;
+			freeSlots.push_back(slot);
+		}
+
+		/**
+		 * @brief Calls f on every live object, one chunk after another.
+		 * @note Index based, so f may create or destroy objects while the pool is walked.
+		 */
+		template<typename F>
+		void ForEach(F&& f) {
+			for(size_t c = 0; c < chunks.size(); c++)
+				for(auto& slot: *chunks[c])
+					if(slot.live) f(slot.Get());
+		}
+	};
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+#define RAYLIB_SUPPORT_OIS
+#include <raylib-cpp.hpp>
+
+#include <optional>
+#include <functional>
+#include <memory>
+#include <utility>
+#include "ECS.hpp"
+#include "Pool.hpp"
+
+// Component/Entity API matching CO.hpp, but with entities and their component masks kept in a cs381::Scene
+// The scene stores a pointer to each component, the components themselves live in one chunked ObjectPool per type
+// (owned by the scene) so each type's components sit together in memory and are ticked together
+// Porting code from CO.hpp mostly means swapping the include and namespace (using namespace cs381::scene)
+// Differences to keep in mind:
+//  - Entity is a small handle (scene + ID) instead of the owner of its components, copies refer to the same entity
+//    so compare entities with == rather than by address
+//  - An entity has at most one component of each type, adding a second replaces (and destroys) the first
+//  - GetComponent<T> finds components of exactly type T (no dynamic_cast to bases)
+//  - AddComponent returns the type's scene wide component ID, not the component's index in the entity like CO.hpp does
+//    (there is no per entity list to index), code which keeps that value must be changed when it is ported
+//  - Components keep their address until they are removed or replaced, the scene destroys whatever is left when it goes
+//  - Like ECS.hpp, the program needs to define globalComponentCounter
+namespace cs381::scene {
+
+	class Component;
+	struct TransformComponent;
+
+	/**
+	 * @brief Entity IDs and component masks (in the ECS scene) plus the pools the components are allocated from.
+	 * @note The ECS scene stores a T* per entity under GetComponentID<T*>, the T itself is in GetPool<T>.
+	 */
+	struct Scene: public cs381::Scene<cs381::ComponentStorage> {
+		/**
+		 * @brief Type erased owner of one component type's pool.
+		 */
+		struct PoolBase {
+			virtual ~PoolBase() {}
+		};
+
+		template<typename T>
+		struct Pool: public PoolBase {
+			ObjectPool<T> objects;
+		};
+
+		std::vector<std::unique_ptr<PoolBase>> pools; // Indexed by GetComponentID<T*>
+
+		Scene() = default;
+		Scene(const Scene&) = delete;
+
+		template<std::derived_from<Component> T>
+		ObjectPool<T>& GetPool() {
+			size_t id = GetComponentID<T*>();
+			if(pools.size() <= id) pools.resize(id + 1);
+			if(!pools[id]) pools[id] = std::make_unique<Pool<T>>();
+			return static_cast<Pool<T>&>(*pools[id]).objects;
+		}
+	};
+
+	/**
+	 * @brief The scene entities are placed in when none is specified.
+	 */
+	inline Scene& DefaultScene() {
+		static Scene scene;
+		return scene;
+	}
+
+	/**
+	 * @brief Handle to an object in the game world, its components are stored in a Scene.
+	 */
+	struct Entity {
+		Scene* scene = nullptr;
+		cs381::Entity id = 0;
+
+		Entity() : Entity(DefaultScene()) {}
+		explicit Entity(Scene& scene); // Creates a new entity (with a transform) in the scene
+		Entity(Scene& scene, cs381::Entity id) : scene(&scene), id(id) {} // Refers to an existing entity
+
+		bool operator==(const Entity& other) const { return scene == other.scene && id == other.id; }
+
+		/**
+		 * @brief Performs actions during each game update for the entity's components.
+		 * @param dt The time elapsed since the last update.
+		 * @note Components are ticked grouped by type (in the order their types were first added), prefer TickScene for whole worlds.
+		 */
+		void Tick(float dt);
+
+		/**
+		 * @brief Adds a new component of type T to the entity.
+		 * @tparam T The type of component to add.
+		 * @tparam Ts The types of arguments to pass to the component's constructor.
+		 * @param args The arguments to pass to the component's constructor.
+		 * @return The scene wide component ID of T (the same for every entity), unlike CO.hpp's index into the entity.
+		 */
+		template<std::derived_from<Component> T, typename... Ts>
+		size_t AddComponent(Ts... args);
+
+		/**
+		 * @brief Removes the component of type T from the entity.
+		 * @tparam T The type of component to remove.
+		 */
+		template<std::derived_from<Component> T>
+		void RemoveComponent() {
+			if(!scene->HasComponent<T*>(id)) return;
+			scene->GetPool<T>().Destroy(scene->GetComponent<T*>(id));
+			scene->RemoveComponent<T*>(id);
+		}
+
+		/**
+		 * @brief Retrieves a component of type T from the entity.
+		 * @tparam T The type of component to retrieve.
+		 * @return An optional reference to the component if found, or std::nullopt if not found.
+		 */
+		template<std::derived_from<Component> T>
+		std::optional<std::reference_wrapper<T>> GetComponent() {
+			if(!scene->HasComponent<T*>(id)) return {};
+			return *scene->GetComponent<T*>(id);
+		}
+
+		/**
+		 * @brief Retrieves this object's transform...
+		 * @return The object's transform component.
+		 * @note this function has undefined behavior (probably a crash...) if the transform component is ever removed!
+		 */
+		TransformComponent& Transform();
+	};
+
+	/**
+	 * @brief Base class for various components that can be attached to an entity.
+	 */
+	class Component {
+		Entity object;
+
+	public:
+		Entity& Object() { return object; }
+		TransformComponent& Transform();
+		bool enabled = true;
+
+		Component(Entity& e) : object(e) {}
+		Component(Entity& e, bool enabled): object(e), enabled(enabled) {} // Start
+		virtual void Tick(float dt) {}
+		virtual ~Component() {}
+
+		template<std::derived_from<Component> T>
+		T& as() { return *dynamic_cast<T*>(this); }
+	};
+
+	/**
+	 * @brief Component storing the positional data of a Entity
+	 */
+	struct TransformComponent: public Component {
+		using Component::Component;
+		raylib::Vector3 position = {0, 0, 0};
+		raylib::Degree heading = 0;
+	};
+
+	/**
+	 * @brief Per type update, ticks every enabled T in the scene in one pass over its pool (or only one entity's T).
+	 */
+	struct TickSystem {
+		void (*tick)(Scene& scene, float dt);
+		void (*tickEntity)(Scene& scene, float dt, cs381::Entity e);
+	};
+
+	/**
+	 * @brief The batch updates of every component type which overrides Tick, in the order the types were first added.
+	 */
+	inline std::vector<TickSystem>& TickSystems() {
+		static std::vector<TickSystem> systems;
+		return systems;
+	}
+
+	/**
+	 * @brief Registers T's batch update the first time a T is added anywhere.
+	 */
+	template<std::derived_from<Component> T>
+	void RegisterTickSystem() {
+		if constexpr(!std::is_same_v<decltype(&T::Tick), void (Component::*)(float)>) { // Types that don't override Tick have nothing to update
+			static bool registered = [] {
+				TickSystems().push_back({
+					[](Scene& scene, float dt) {
+						scene.GetPool<T>().ForEach([dt](T& component) {
+							if(component.enabled)
+								component.T::Tick(dt); // We know the exact type, so skip the virtual call
+						});
+					},
+					[](Scene& scene, float dt, cs381::Entity e) {
+						if(!scene.HasComponent<T*>(e)) return;
+						T& component = *scene.GetComponent<T*>(e);
+						if(component.enabled)
+							component.T::Tick(dt);
+					}
+				});
+				return true;
+			}();
+			(void)registered;
+		}
+	}
+
+	/**
+	 * @brief Ticks every component in the scene, one component type at a time.
+	 * @param dt The time elapsed since the last update.
+	 */
+	inline void TickScene(Scene& scene, float dt) {
+		for(auto& system: TickSystems())
+			system.tick(scene, dt);
+	}
+
+	inline Entity::Entity(Scene& scene) : scene(&scene), id(scene.CreateEntity()) {
+		AddComponent<TransformComponent>(); // Entities have a transform by default!
+	}
+
+	template<std::derived_from<Component> T, typename... Ts>
+	size_t Entity::AddComponent(Ts... args) {
+		RegisterTickSystem<T>();
+		auto& pool = scene->GetPool<T>();
+		T* component = pool.Create(*this, std::forward<Ts>(args)...);
+		if(scene->HasComponent<T*>(id)) // Only one per type, the new component replaces the old one
+			pool.Destroy(std::exchange(scene->GetComponent<T*>(id), component));
+		else scene->AddComponent<T*>(id) = component;
+		return GetComponentID<T*>();
+	}
+
+	inline void Entity::Tick(float dt) {
+		for(auto& system: TickSystems())
+			system.tickEntity(*scene, dt, id);
+	}
+
+	inline TransformComponent& Entity::Transform() { return *GetComponent<TransformComponent>(); }
+
+	/**
+	 * @brief Syntax sugar function that provides access to the object's transform component
+	 * @return The object's transform component.
+	 * @note this function has undefined behavior (probably a crash...) if the transform component is ever removed!
+	 */
+	inline TransformComponent& Component::Transform() { return Object().Transform(); }
+}
@@ -3,9 +3,19 @@
 #include <vector>
 #include <chrono>
 #include "skybox.hpp"
+#include "FixedTimestep.hpp"
+
+// The same components run on either backend: CO.hpp's pooled entities, or SceneCO.hpp's Scene (the as7_scene target)
+#ifdef AS7_SCENE_BACKEND
+#include "SceneCO.hpp"
+using namespace cs381::scene;
+size_t globalComponentCounter = 0;
+void TickWorld(float dt) { TickScene(DefaultScene(), dt); }
+#else
 #include "CO.hpp"
-
 using namespace cs381;
+void TickWorld(float dt) { DefaultRegistry().Tick(dt); }
+#endif
 
 template<typename T>
 concept Transformer = requires(T t, raylib::Matrix m) {
@@ -21,24 +31,36 @@ void DrawBoundedModel(raylib::Model& model, Transformer auto transformer) {
 
 Entity* gSelectedEntity = nullptr;
 
+// Drawn once per frame (not ticked), between where the entity was before and after the last simulation tick
 struct MeshRenderComponent : public Component {
     raylib::Model* model = nullptr;
     bool drawBoundingBox = false;
-    using Component::Component;
+    raylib::Vector3 previousPosition = {0, 0, 0};
+    float previousHeading = 0;
 
-    void Tick(float dt) override {
+    MeshRenderComponent(Entity& e) : Component(e) { StorePrevious(); }
+
+    void StorePrevious() {  // Called before every tick
+        auto& transform = Object().Transform();
+        previousPosition = transform.position;
+        previousHeading = static_cast<float>(transform.heading);
+    }
+
+    void Draw(float alpha) {  // alpha is how far the frame is from the previous tick to the current one
         if (!model) return;
         auto& transform = Object().Transform();
+        raylib::Vector3 position = Vector3Lerp(previousPosition, transform.position, alpha);
+        float heading = cs381::LerpDegrees(previousHeading, static_cast<float>(transform.heading), alpha);
         DrawBoundedModel(*model, [&](raylib::Matrix matrix) {
             return raylib::Matrix::Identity()
                 .Scale(5.0f)
-                .RotateY(static_cast<float>(transform.heading) * DEG2RAD)
-                .Translate(transform.position);
+                .RotateY(heading * DEG2RAD)
+                .Translate(position);
         });
         if (drawBoundingBox) {
             raylib::BoundingBox box = model->GetBoundingBox();
-            box.min = raylib::Vector3(box.min) * 5.0f + transform.position;
-            box.max = raylib::Vector3(box.max) * 5.0f + transform.position;
+            box.min = raylib::Vector3(box.min) * 5.0f + position;
+            box.max = raylib::Vector3(box.max) * 5.0f + position;
             DrawBoundingBox(box, RED);
         }
     }
@@ -66,17 +88,28 @@ struct InputComponent : public Component {
     PhysicsComponent* physics;
     TransformComponent* transform;
 
+    bool pressedW = false, pressedS = false, pressedA = false, pressedD = false, pressedSpace = false;  // Since the last tick
+
     InputComponent(Entity& e, PhysicsComponent* phys, TransformComponent* trans)
         : Component(e), physics(phys), transform(trans) {}
 
-    void Tick(float dt) override {
-        if (&Object() != gSelectedEntity) return;
+    void Poll() {  // Called every frame, a frame may run no ticks and its presses must wait for the next one
+        pressedW |= IsKeyPressed(KEY_W);
+        pressedS |= IsKeyPressed(KEY_S);
+        pressedA |= IsKeyPressed(KEY_A);
+        pressedD |= IsKeyPressed(KEY_D);
+        pressedSpace |= IsKeyPressed(KEY_SPACE);
+    }
 
-        if (IsKeyPressed(KEY_W)) physics->velocity += physics->acceleration;
-        if (IsKeyPressed(KEY_S)) physics->velocity -= physics->acceleration;
-        if (IsKeyPressed(KEY_A)) transform->heading += 15;
-        if (IsKeyPressed(KEY_D)) transform->heading -= 15;
-        if (IsKeyPressed(KEY_SPACE)) physics->velocity = 0;
+    void Tick(float dt) override {
+        if (Object() != *gSelectedEntity) return;
+
+        if (pressedW) physics->velocity += physics->acceleration;
+        if (pressedS) physics->velocity -= physics->acceleration;
+        if (pressedA) transform->heading += 15;
+        if (pressedD) transform->heading -= 15;
+        if (pressedSpace) physics->velocity = 0;
+        pressedW = pressedS = pressedA = pressedD = pressedSpace = false;
     }
 };
 
@@ -124,6 +157,7 @@ int main() {
     );
 
     auto lastTime = std::chrono::high_resolution_clock::now();
+    cs381::FixedTimestep timestep;  // The world ticks at 60 Hz whatever the frame rate, so a long frame can't skip the car past the goal
 
     while (!window.ShouldClose()) {
         auto currentTime = std::chrono::high_resolution_clock::now();
@@ -131,15 +165,20 @@ int main() {
         lastTime = currentTime;
         float dt = deltaTime.count();
 
-        // Collision
-        auto& carTransform = entities[0].Transform();
-        if (CheckCollisionSpheres(carTransform.position, 2.5f, goalPosition, goalRadius)) {
-            score++;
-            std::cout << "Goal Reached! Score: " << score << std::endl;
-            carTransform.position = raylib::Vector3(5.0f, 0.0f, -5.0f);
-        }
+        if (auto input = gSelectedEntity->GetComponent<InputComponent>()) input->get().Poll();
+        for (int steps = timestep.Advance(dt); steps > 0; --steps) {
+            // Collision
+            auto& carTransform = entities[0].Transform();
+            if (CheckCollisionSpheres(carTransform.position, 2.5f, goalPosition, goalRadius)) {
+                score++;
+                std::cout << "Goal Reached! Score: " << score << std::endl;
+                carTransform.position = raylib::Vector3(5.0f, 0.0f, -5.0f);
+            }
 
-        for (auto& entity : entities) entity.Tick(dt);
+            for (auto& entity : entities)  // After the collision, so a reset car isn't drawn sliding back to the start
+                if (auto renderComp = entity.GetComponent<MeshRenderComponent>()) renderComp->get().StorePrevious();
+            TickWorld(timestep.StepSize());
+        }
 
         window.BeginDrawing();
         window.ClearBackground(raylib::Color(0, 0, 0, 255));
@@ -150,7 +189,7 @@ int main() {
             goalModel.Draw(goalPosition, 1.0f, WHITE);
             for (auto& entity : entities) {
                 if (auto renderComp = entity.GetComponent<MeshRenderComponent>(); renderComp.has_value()) {
-                    renderComp->get().Tick(0);
+                    renderComp->get().Draw(timestep.Alpha());
                 }
             }
         EndMode3D();
@@ -0,0 +1,19 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec2 fragTexCoord;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+
+// Output fragment color
+out vec4 finalColor;
+
+void main()
+{
+    // Alpha tested instead of blended, so impostors write depth and need no back to front sorting
+    vec4 texelColor = texture(texture0, fragTexCoord);
+    if (texelColor.a < 0.5) discard;
+    finalColor = texelColor*colDiffuse;
+}
\ No newline at end of file
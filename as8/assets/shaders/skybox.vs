@@ -19,6 +19,7 @@ void main()
     mat4 rotView = mat4(mat3(matView));
     vec4 clipPos = matProjection*rotView*vec4(vertexPosition, 1.0);
 
-    // Calculate final vertex position
-    gl_Position = clipPos;
+    // Calculate final vertex position, z = w puts the sky on the far plane (depth 1) so it is drawn last and only
+    // where nothing else was drawn (raylib's depth test is LEQUAL)
+    gl_Position = clipPos.xyww;
 }
\ No newline at end of file
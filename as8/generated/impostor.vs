@@ -0,0 +1,25 @@
+R"for_C++_include(#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in mat4 instanceTransform;  // Per impostor billboard matrix (DrawMeshInstanced)
+
+// Input uniform values
+uniform mat4 mvp;
+
+// Output vertex attributes (to fragment shader)
+out vec2 fragTexCoord;
+
+void main()
+{
+    // The atlas cell (u, v of its corner and its size) rides in the bottom row of the matrix, which is unused by an affine transform
+    mat4 transform = instanceTransform;
+    vec3 cell = vec3(transform[0][3], transform[1][3], transform[2][3]);
+    transform[0][3] = 0.0;
+    transform[1][3] = 0.0;
+    transform[2][3] = 0.0;
+
+    fragTexCoord = cell.xy + vertexTexCoord*cell.z;
+    gl_Position = mvp*transform*vec4(vertexPosition, 1.0);
+})for_C++_include"
\ No newline at end of file
@@ -0,0 +1,23 @@
+R"for_C++_include(#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in vec4 vertexColor;
+in mat4 instanceTransform;  // Per instance model matrix (DrawMeshInstanced)
+
+// Input uniform values
+uniform mat4 mvp;
+
+// Output vertex attributes (to fragment shader)
+out vec2 fragTexCoord;
+out vec4 fragColor;
+
+void main()
+{
+    fragTexCoord = vertexTexCoord;
+    fragColor = vertexColor;
+
+    // Calculate final vertex position, the instance transform replaces the model matrix
+    gl_Position = mvp*instanceTransform*vec4(vertexPosition, 1.0);
+})for_C++_include"
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "BVH.hpp"
+#include <raymath.h>
+#include <algorithm>
+#include <cstring>
+
+namespace cs381 {
+
+	constexpr int binCount = 12;  // Candidate split planes per axis
+
+	static const BoundingBox emptyBox = { { INFINITY, INFINITY, INFINITY }, { -INFINITY, -INFINITY, -INFINITY } };
+
+	static BoundingBox Union(const BoundingBox& a, const BoundingBox& b) {
+		return { Vector3Min(a.min, b.min), Vector3Max(a.max, b.max) };
+	}
+
+	static float Area(const BoundingBox& box) {
+		Vector3 size = Vector3Subtract(box.max, box.min);
+		if (size.x < 0 || size.y < 0 || size.z < 0) return 0;
+		return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	static float Component(Vector3 v, int axis) { return axis == 0 ? v.x : axis == 1 ? v.y : v.z; }
+
+	static float Centroid(const BoundingBox& box, int axis) { return (Component(box.min, axis) + Component(box.max, axis)) * 0.5f; }
+
+	// Distance along the ray to where it enters the box (0 when it starts inside), INFINITY when it misses
+	static float RayBox(const Ray& ray, Vector3 inverseDirection, const BoundingBox& box) {
+		float tNear = 0, tFar = INFINITY;
+		for (int axis = 0; axis < 3; ++axis) {
+			float origin = Component(ray.position, axis), inverse = Component(inverseDirection, axis);
+			float t1 = (Component(box.min, axis) - origin) * inverse, t2 = (Component(box.max, axis) - origin) * inverse;
+			// fminf/fmaxf ignore the NaN an axis parallel ray gives when it starts on a face
+			tNear = fmaxf(tNear, fminf(t1, t2));
+			tFar = fminf(tFar, fmaxf(t1, t2));
+		}
+		return tNear <= tFar ? tNear : INFINITY;
+	}
+
+	void BVH::Build(std::span<const uint32_t> ids, std::span<const BoundingBox> boxes) {
+		nodes.clear();
+		items.assign(ids.begin(), ids.end());
+		uint32_t maxId = 0;
+		for (auto id : ids) maxId = std::max(maxId, id);
+		itemBounds.assign(maxId + 1, emptyBox);
+		leafOf.assign(maxId + 1, -1);
+		for (size_t i = 0; i < ids.size(); ++i) itemBounds[ids[i]] = boxes[i];
+		buildCost = 0;
+		if (items.empty()) return;
+
+		nodes.push_back({ emptyBox, 0, (uint32_t)items.size(), -1 });
+		std::vector<uint32_t> pending = { 0 };
+		while (!pending.empty()) {
+			uint32_t node = pending.back();
+			pending.pop_back();
+			Split(node);
+			if (nodes[node].count == 0) {
+				pending.push_back(nodes[node].first);
+				pending.push_back(nodes[node].first + 1);
+			}
+		}
+
+		for (uint32_t n = 0; n < nodes.size(); ++n)
+			for (uint32_t i = 0; i < nodes[n].count; ++i)
+				leafOf[items[nodes[n].first + i]] = n;
+		buildCost = Cost();
+	}
+
+	void BVH::Split(uint32_t node) {
+		uint32_t first = nodes[node].first, count = nodes[node].count;
+		auto begin = items.begin() + first, end = begin + count;
+		BoundingBox bounds = emptyBox, centroids = emptyBox;
+		for (auto it = begin; it != end; ++it) {
+			const BoundingBox& box = itemBounds[*it];
+			bounds = Union(bounds, box);
+			Vector3 center = Vector3Scale(Vector3Add(box.min, box.max), 0.5f);
+			centroids = Union(centroids, { center, center });
+		}
+		nodes[node].bounds = bounds;
+		if (count <= 1) return;
+
+		// Bin the centroids along every axis and keep the plane with the lowest SAH cost (area times item count on each side)
+		float bestCost = INFINITY, bestPlane = 0;
+		int bestAxis = -1;
+		for (int axis = 0; axis < 3; ++axis) {
+			float low = Component(centroids.min, axis), extent = Component(centroids.max, axis) - low;
+			if (extent <= 0) continue;
+			BoundingBox binBounds[binCount];
+			uint32_t binItems[binCount] = {};
+			std::fill_n(binBounds, binCount, emptyBox);
+			for (auto it = begin; it != end; ++it) {
+				int bin = std::min(binCount - 1, (int)((Centroid(itemBounds[*it], axis) - low) / extent * binCount));
+				binBounds[bin] = Union(binBounds[bin], itemBounds[*it]);
+				binItems[bin]++;
+			}
+
+			float rightArea[binCount];
+			uint32_t rightItems[binCount];
+			BoundingBox right = emptyBox;
+			uint32_t rightCount = 0;
+			for (int i = binCount - 1; i > 0; --i) {
+				right = Union(right, binBounds[i]);
+				rightCount += binItems[i];
+				rightArea[i] = Area(right);
+				rightItems[i] = rightCount;
+			}
+			BoundingBox left = emptyBox;
+			uint32_t leftCount = 0;
+			for (int i = 1; i < binCount; ++i) {  // Plane between bin i - 1 and bin i
+				left = Union(left, binBounds[i - 1]);
+				leftCount += binItems[i - 1];
+				if (leftCount == 0 || rightItems[i] == 0) continue;
+				float cost = Area(left) * leftCount + rightArea[i] * rightItems[i];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestPlane = low + extent * i / binCount;
+				}
+			}
+		}
+
+		uint32_t leftCount;
+		if (bestAxis >= 0) {
+			// Traversing plus testing both halves against testing every item here
+			if (count <= maxLeafItems && bestCost >= Area(bounds) * count) return;
+			auto middle = std::partition(begin, end, [&](uint32_t id) { return Centroid(itemBounds[id], bestAxis) < bestPlane; });
+			leftCount = middle - begin;
+		} else {
+			// Every centroid is in the same place, no plane separates them
+			if (count <= maxLeafItems) return;
+			leftCount = count / 2;
+		}
+
+		uint32_t child = nodes.size();
+		nodes[node].first = child;
+		nodes[node].count = 0;
+		nodes.push_back({ emptyBox, first, leftCount, (int32_t)node });
+		nodes.push_back({ emptyBox, first + leftCount, count - leftCount, (int32_t)node });
+	}
+
+	void BVH::RefitNode(uint32_t node) {
+		Node& n = nodes[node];
+		if (n.count == 0) {
+			n.bounds = Union(nodes[n.first].bounds, nodes[n.first + 1].bounds);
+			return;
+		}
+		n.bounds = emptyBox;
+		for (uint32_t i = 0; i < n.count; ++i) n.bounds = Union(n.bounds, itemBounds[items[n.first + i]]);
+	}
+
+	void BVH::Update(uint32_t id, const BoundingBox& box) {
+		if (!Contains(id)) return;
+		itemBounds[id] = box;
+		for (int32_t node = leafOf[id]; node >= 0; node = nodes[node].parent) {
+			BoundingBox previous = nodes[node].bounds;
+			RefitNode(node);
+			if (!std::memcmp(&previous, &nodes[node].bounds, sizeof(BoundingBox))) break;  // Nothing above can change either
+		}
+	}
+
+	float BVH::Cost() const {
+		if (nodes.empty()) return 0;
+		float cost = 0;
+		for (auto& node : nodes) cost += Area(node.bounds) * (node.count == 0 ? 1 : node.count);
+		float rootArea = Area(nodes[0].bounds);
+		return rootArea > 0 ? cost / rootArea : cost;
+	}
+
+	BVH::Hit BVH::Raycast(const Ray& ray, float maxDistance, const std::function<float(uint32_t)>& test) const {
+		Hit best = { UINT32_MAX, maxDistance };
+		if (nodes.empty()) return best;
+		Vector3 inverse = { 1 / ray.direction.x, 1 / ray.direction.y, 1 / ray.direction.z };
+
+		std::vector<std::pair<uint32_t, float>> pending;  // Node and where the ray enters it
+		pending.reserve(64);
+		float rootDistance = RayBox(ray, inverse, nodes[0].bounds);
+		if (rootDistance < best.distance) pending.push_back({ 0, rootDistance });
+		while (!pending.empty()) {
+			auto [index, distance] = pending.back();
+			pending.pop_back();
+			if (distance >= best.distance) continue;  // Something closer was found since this was pushed
+
+			const Node& node = nodes[index];
+			if (node.count > 0) {
+				for (uint32_t i = 0; i < node.count; ++i) {
+					uint32_t id = items[node.first + i];
+					float hit = RayBox(ray, inverse, itemBounds[id]);
+					if (hit >= best.distance) continue;
+					if (test) hit = test(id);
+					if (hit < best.distance) best = { id, hit };
+				}
+				continue;
+			}
+
+			// Nearer child goes on top, so it is visited first
+			float left = RayBox(ray, inverse, nodes[node.first].bounds), right = RayBox(ray, inverse, nodes[node.first + 1].bounds);
+			std::pair<uint32_t, float> nearer = { node.first, left }, farther = { node.first + 1, right };
+			if (right < left) std::swap(nearer, farther);
+			if (farther.second < best.distance) pending.push_back(farther);
+			if (nearer.second < best.distance) pending.push_back(nearer);
+		}
+		return best;
+	}
+
+	void BVH::Overlapping(const BoundingBox& box, std::vector<uint32_t>& out) const {
+		if (nodes.empty()) return;
+		std::vector<uint32_t> pending = { 0 };
+		while (!pending.empty()) {
+			const Node& node = nodes[pending.back()];
+			pending.pop_back();
+			if (!CheckCollisionBoxes(node.bounds, box)) continue;
+			if (node.count == 0) {
+				pending.push_back(node.first);
+				pending.push_back(node.first + 1);
+				continue;
+			}
+			for (uint32_t i = 0; i < node.count; ++i) {
+				uint32_t id = items[node.first + i];
+				if (CheckCollisionBoxes(itemBounds[id], box)) out.push_back(id);
+			}
+		}
+	}
+
+	void BVH::Visible(const Frustum& frustum, std::vector<uint32_t>& out) const {
+		if (nodes.empty()) return;
+		std::vector<uint32_t> pending = { 0 };
+		while (!pending.empty()) {
+			const Node& node = nodes[pending.back()];
+			pending.pop_back();
+			if (!frustum.ContainsBox(node.bounds)) continue;
+			if (node.count == 0) {
+				pending.push_back(node.first);
+				pending.push_back(node.first + 1);
+				continue;
+			}
+			for (uint32_t i = 0; i < node.count; ++i) {
+				uint32_t id = items[node.first + i];
+				if (frustum.ContainsBox(itemBounds[id])) out.push_back(id);
+			}
+		}
+	}
+}
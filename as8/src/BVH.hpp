@@ -0,0 +1,63 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include <raylib.h>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+#include "Bounds.hpp"
+
+namespace cs381 {
+
+	// Bounding volume hierarchy over (id, world box) items, e.g. entities or static level chunks
+	// Build splits with the surface area heuristic (binned), which gives the cheapest trees to query and is meant for
+	// items which rarely move. Moving items call Update instead, which refits the boxes above them without changing the
+	// tree's shape; the tree gets looser as things move, so rebuild once Degraded says the cost has grown too much
+	// Ids index a vector, keep them small (entity ids, array indices...)
+	struct BVH {
+		constexpr static int maxLeafItems = 4;
+
+		struct Hit {
+			uint32_t id = UINT32_MAX;  // UINT32_MAX when nothing was hit
+			float distance = INFINITY;
+		};
+
+		float rebuildRatio = 2;  // Degraded once the tree costs this many times what it did when built
+
+		void Build(std::span<const uint32_t> ids, std::span<const BoundingBox> boxes);  // Replaces everything, boxes[i] belongs to ids[i]
+		void Update(uint32_t id, const BoundingBox& box);  // Moves a built item, refitting its ancestors
+		bool Degraded() const { return Cost() > buildCost * rebuildRatio; }
+		float Cost() const;  // Expected work for a random ray (SAH), relative to testing the root's box
+
+		bool Contains(uint32_t id) const { return id < leafOf.size() && leafOf[id] >= 0; }
+		size_t Size() const { return items.size(); }
+
+		// Nearest item along the ray within maxDistance. Items whose box is hit are passed to test (when given), which returns
+		// the exact distance or INFINITY for a miss (e.g. a mesh test); without it the distance to the box is used
+		// Boxes are visited nearest first, so test only runs for items which could still beat the best hit
+		Hit Raycast(const Ray& ray, float maxDistance = INFINITY, const std::function<float(uint32_t)>& test = {}) const;
+		void Overlapping(const BoundingBox& box, std::vector<uint32_t>& out) const;  // Appends the ids of items whose box overlaps
+		void Visible(const Frustum& frustum, std::vector<uint32_t>& out) const;  // Appends the ids of items whose box isn't entirely outside
+
+	protected:
+		struct Node {
+			BoundingBox bounds;
+			uint32_t first;  // Leaves: first entry of items, interior nodes: left child (the right child follows it)
+			uint32_t count;  // Items in a leaf, 0 for interior nodes
+			int32_t parent;
+		};
+
+		std::vector<Node> nodes;  // Parents always come before their children, nodes[0] is the root
+		std::vector<uint32_t> items;  // Ids, grouped by leaf
+		std::vector<BoundingBox> itemBounds;  // By id
+		std::vector<int32_t> leafOf;  // By id, -1 for ids not in the tree
+		float buildCost = 0;
+
+		void Split(uint32_t node);
+		void RefitNode(uint32_t node);
+	};
+}
+
+#endif // BVH_HPP
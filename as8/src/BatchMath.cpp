@@ -0,0 +1,72 @@
+#include "BatchMath.hpp"
+
+#include <cassert>
+
+// Baseline kernels: SSE2 on x86-64, NEON on 64 bit ARM, plain floats anywhere else
+#if defined(__SSE2__)
+	#define CS381_BATCH_ISA baseline
+	#define CS381_BATCH_NAME "sse2"
+	#define CS381_BATCH_WIDTH 4
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+	#define CS381_BATCH_ISA baseline
+	#define CS381_BATCH_NAME "neon"
+	#define CS381_BATCH_WIDTH 4
+#else
+	#define CS381_BATCH_ISA baseline
+	#define CS381_BATCH_NAME "scalar"
+	#define CS381_BATCH_WIDTH 1
+#endif
+#include "BatchMathImpl.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+	#define CS381_BATCH_HAS_AVX2
+	namespace cs381::batch::detail::avx2 { extern const Implementation implementation; }  // BatchMathAVX2.cpp
+#endif
+
+namespace cs381::batch {
+
+	namespace {
+		const detail::Implementation& Active() {  // Chosen once, on first use
+			static const detail::Implementation& active = []() -> const detail::Implementation& {
+#ifdef CS381_BATCH_HAS_AVX2
+				if(__builtin_cpu_supports("avx2"))
+					return detail::avx2::implementation;
+#endif
+				return detail::baseline::implementation;
+			}();
+			return active;
+		}
+
+		detail::Floats3 Pointers(Vector3Array& v) { return {v.x.data(), v.y.data(), v.z.data()}; }
+		detail::ConstFloats3 Pointers(const Vector3Array& v) { return {v.x.data(), v.y.data(), v.z.data()}; }
+		detail::Floats4 Pointers(QuaternionArray& q) { return {q.x.data(), q.y.data(), q.z.data(), q.w.data()}; }
+		detail::ConstFloats4 Pointers(const QuaternionArray& q) { return {q.x.data(), q.y.data(), q.z.data(), q.w.data()}; }
+	}
+
+	void Multiply(std::span<const ::Matrix> left, std::span<const ::Matrix> right, std::span<::Matrix> out) {
+		assert(right.size() == left.size() && out.size() >= left.size());
+		Active().multiplyMatrices(left.data(), right.data(), out.data(), left.size());
+	}
+
+	void Multiply(const QuaternionArray& left, const QuaternionArray& right, QuaternionArray& out) {
+		assert(right.size() == left.size());
+		if(out.size() < left.size()) out.resize(left.size());
+		Active().multiplyQuaternions(Pointers(left), Pointers(right), Pointers(out), left.size());
+	}
+
+	void RotateByQuaternion(const Vector3Array& v, const QuaternionArray& rotation, Vector3Array& out) {
+		assert(rotation.size() == v.size());
+		if(out.size() < v.size()) out.resize(v.size());
+		Active().rotateByQuaternion(Pointers(v), Pointers(rotation), Pointers(out), v.size());
+	}
+
+	void Normalize(Vector3Array& v) { Active().normalize3(Pointers(v), v.size()); }
+	void Normalize(QuaternionArray& q) { Active().normalize4(Pointers(q), q.size()); }
+
+	void ComposeTRS(const Vector3Array& translation, const QuaternionArray& rotation, const Vector3Array& scale, std::span<::Matrix> out) {
+		assert(rotation.size() == translation.size() && scale.size() == translation.size() && out.size() >= translation.size());
+		Active().composeTRS(Pointers(translation), Pointers(rotation), Pointers(scale), out.data(), translation.size());
+	}
+
+	const char* InstructionSet() { return Active().name; }
+}
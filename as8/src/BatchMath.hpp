@@ -0,0 +1,67 @@
+#ifndef BATCH_MATH_HPP
+#define BATCH_MATH_HPP
+
+#include <raylib.h>
+#include <span>
+#include <vector>
+#include <cstddef>
+
+namespace cs381::batch {
+
+	// Batch versions of raymath's per entity transform math
+	// Vectors and quaternions are stored SoA (one array per component) so every lane of a SIMD register holds a
+	// different entity. Matrices are written as plain raylib Matrix arrays (the layout DrawMesh/DrawMeshInstanced
+	// expect), so results can be handed straight to draw calls
+	// Every operation matches the raymath function it replaces bit for bit (same operations in the same order, no FMA),
+	// ComposeTRS can only differ in the sign of zero entries
+	// An AVX2 version is picked at runtime when the CPU supports it, otherwise SSE2/NEON (4 lanes) is used
+
+	struct Vector3Array {
+		std::vector<float> x, y, z;
+
+		Vector3Array(size_t count = 0) { resize(count); }
+
+		size_t size() const { return x.size(); }
+		void resize(size_t count) { x.resize(count); y.resize(count); z.resize(count); }
+		void clear() { x.clear(); y.clear(); z.clear(); }
+
+		::Vector3 Get(size_t i) const { return {x[i], y[i], z[i]}; }
+		void Set(size_t i, ::Vector3 v) { x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+		void push_back(::Vector3 v) { x.push_back(v.x); y.push_back(v.y); z.push_back(v.z); }
+	};
+
+	struct QuaternionArray {
+		std::vector<float> x, y, z, w;
+
+		QuaternionArray(size_t count = 0) { resize(count); }
+
+		size_t size() const { return x.size(); }
+		void resize(size_t count) { x.resize(count); y.resize(count); z.resize(count); w.resize(count, 1); }  // New entries start as the identity
+		void clear() { x.clear(); y.clear(); z.clear(); w.clear(); }
+
+		::Quaternion Get(size_t i) const { return {x[i], y[i], z[i], w[i]}; }
+		void Set(size_t i, ::Quaternion q) { x[i] = q.x; y[i] = q.y; z[i] = q.z; w[i] = q.w; }
+		void push_back(::Quaternion q) { x.push_back(q.x); y.push_back(q.y); z.push_back(q.z); w.push_back(q.w); }
+	};
+
+	// out[i] = MatrixMultiply(left[i], right[i]), out may alias either input
+	void Multiply(std::span<const ::Matrix> left, std::span<const ::Matrix> right, std::span<::Matrix> out);
+
+	// out[i] = QuaternionMultiply(left[i], right[i]), out may alias either input
+	void Multiply(const QuaternionArray& left, const QuaternionArray& right, QuaternionArray& out);
+
+	// out[i] = Vector3RotateByQuaternion(v[i], rotation[i]), out may alias v
+	void RotateByQuaternion(const Vector3Array& v, const QuaternionArray& rotation, Vector3Array& out);
+
+	// Vector3Normalize / QuaternionNormalize in place
+	void Normalize(Vector3Array& v);
+	void Normalize(QuaternionArray& q);
+
+	// out[i] = scale, then rotate, then translate (MatrixMultiply(MatrixMultiply(MatrixScale, QuaternionToMatrix), MatrixTranslate))
+	// Computed in closed form, 9 multiplies per matrix instead of two full matrix products
+	void ComposeTRS(const Vector3Array& translation, const QuaternionArray& rotation, const Vector3Array& scale, std::span<::Matrix> out);
+
+	const char* InstructionSet();  // Name of the implementation in use ("avx2", "sse2", "neon" or "scalar")
+}
+
+#endif // BATCH_MATH_HPP
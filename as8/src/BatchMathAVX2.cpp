@@ -0,0 +1,8 @@
+// AVX2 versions of the batch math kernels, this file is compiled with -mavx2 (see CMakeLists.txt)
+// and only ever called after BatchMath.cpp has checked that the CPU supports it
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__AVX2__)
+	#define CS381_BATCH_ISA avx2
+	#define CS381_BATCH_NAME "avx2"
+	#define CS381_BATCH_WIDTH 8
+	#include "BatchMathImpl.hpp"
+#endif
@@ -0,0 +1,207 @@
+// Internal to BatchMath.cpp and BatchMathAVX2.cpp, not part of the public API
+// Included once per instruction set: CS381_BATCH_ISA names the namespace the kernels go in, CS381_BATCH_NAME is the
+// name InstructionSet reports and CS381_BATCH_WIDTH is how many floats one register holds
+// Only raw pointers cross into here, so nothing inline from the standard library gets compiled with a wider
+// instruction set than the rest of the program (the linker could pick that copy)
+
+#ifndef BATCH_MATH_IMPL_COMMON
+#define BATCH_MATH_IMPL_COMMON
+
+#include <raylib.h>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+
+namespace cs381::batch::detail {
+	struct Floats3 { float *x, *y, *z; };
+	struct Floats4 { float *x, *y, *z, *w; };
+	struct ConstFloats3 { const float *x, *y, *z; };
+	struct ConstFloats4 { const float *x, *y, *z, *w; };
+
+	struct Implementation {
+		const char* name;
+		void (*multiplyMatrices)(const ::Matrix* left, const ::Matrix* right, ::Matrix* out, size_t count);
+		void (*multiplyQuaternions)(ConstFloats4 left, ConstFloats4 right, Floats4 out, size_t count);
+		void (*rotateByQuaternion)(ConstFloats3 v, ConstFloats4 rotation, Floats3 out, size_t count);
+		void (*normalize3)(Floats3 v, size_t count);
+		void (*normalize4)(Floats4 q, size_t count);
+		void (*composeTRS)(ConstFloats3 translation, ConstFloats4 rotation, ConstFloats3 scale, ::Matrix* out, size_t count);
+	};
+}
+
+#endif // BATCH_MATH_IMPL_COMMON
+
+#if !defined(CS381_BATCH_ISA) || !defined(CS381_BATCH_WIDTH) || !defined(CS381_BATCH_NAME)
+	#error "Define CS381_BATCH_ISA, CS381_BATCH_NAME and CS381_BATCH_WIDTH before including BatchMathImpl.hpp"
+#endif
+
+#if CS381_BATCH_WIDTH == 8
+	#include <immintrin.h>
+#elif CS381_BATCH_WIDTH == 4 && defined(__SSE2__)
+	#include <emmintrin.h>
+#elif CS381_BATCH_WIDTH == 4 && defined(__ARM_NEON)
+	#include <arm_neon.h>
+#endif
+
+namespace cs381::batch::detail::CS381_BATCH_ISA {
+
+#if CS381_BATCH_WIDTH > 1
+	typedef float Lanes __attribute__((vector_size(CS381_BATCH_WIDTH * sizeof(float))));  // One float per entity
+#else
+	using Lanes = float;
+#endif
+	typedef float Row __attribute__((vector_size(4 * sizeof(float))));  // One row of a Matrix
+
+	template<typename T> inline T Load(const float* p) { T v; std::memcpy(&v, p, sizeof(T)); return v; }
+	template<typename T> inline void Store(float* p, T v) { std::memcpy(p, &v, sizeof(T)); }
+	template<typename T> inline T Broadcast(float f) { if constexpr(sizeof(T) == sizeof(float)) return f; else return T{} + f; }
+	inline float LaneOf(float v, int) { return v; }
+#if CS381_BATCH_WIDTH > 1
+	inline float LaneOf(Lanes v, int lane) { return v[lane]; }
+#endif
+
+	inline float Sqrt(float v) { return std::sqrt(v); }
+#if CS381_BATCH_WIDTH == 8
+	inline Lanes Sqrt(Lanes v) { return (Lanes)_mm256_sqrt_ps((__m256)v); }
+#elif CS381_BATCH_WIDTH == 4 && defined(__SSE2__)
+	inline Lanes Sqrt(Lanes v) { return (Lanes)_mm_sqrt_ps((__m128)v); }
+#elif CS381_BATCH_WIDTH == 4 && defined(__ARM_NEON)
+	inline Lanes Sqrt(Lanes v) { return (Lanes)vsqrtq_f32((float32x4_t)v); }
+#endif
+
+	// The math, written once for a single float (leftovers) and for a register of lanes. Expressions mirror raymath's
+	// exactly, including the order operations are evaluated in, so the results are bit identical
+
+	template<typename T>
+	inline void QuaternionMultiplyOne(T ax, T ay, T az, T aw, T bx, T by, T bz, T bw, T& x, T& y, T& z, T& w) {
+		x = ax*bw + aw*bx + ay*bz - az*by;
+		y = ay*bw + aw*by + az*bx - ax*bz;
+		z = az*bw + aw*bz + ax*by - ay*bx;
+		w = aw*bw - ax*bx - ay*by - az*bz;
+	}
+
+	template<typename T>
+	inline void RotateOne(T vx, T vy, T vz, T qx, T qy, T qz, T qw, T& x, T& y, T& z) {
+		x = vx*(qx*qx + qw*qw - qy*qy - qz*qz) + vy*(2.0f*qx*qy - 2.0f*qw*qz) + vz*(2.0f*qx*qz + 2.0f*qw*qy);
+		y = vx*(2.0f*qw*qz + 2.0f*qx*qy) + vy*(qw*qw - qx*qx + qy*qy - qz*qz) + vz*(-2.0f*qw*qx + 2.0f*qy*qz);
+		z = vx*(-2.0f*qw*qy + 2.0f*qx*qz) + vy*(2.0f*qw*qx + 2.0f*qy*qz) + vz*(qw*qw - qx*qx - qy*qy + qz*qz);
+	}
+
+	template<typename T>
+	inline void Normalize3One(T& x, T& y, T& z) {
+		T length = Sqrt(x*x + y*y + z*z);
+		T ilength = 1.0f/(length == 0.0f ? Broadcast<T>(1.0f) : length);  // Zero vectors are left alone (they stay zero)
+		x = x*ilength; y = y*ilength; z = z*ilength;
+	}
+
+	template<typename T>
+	inline void Normalize4One(T& x, T& y, T& z, T& w) {
+		T length = Sqrt(x*x + y*y + z*z + w*w);
+		T ilength = 1.0f/(length == 0.0f ? Broadcast<T>(1.0f) : length);
+		x = x*ilength; y = y*ilength; z = z*ilength; w = w*ilength;
+	}
+
+	template<typename T>  // The 16 entries of a Matrix in the order they are laid out in memory (m0, m4, m8, m12, m1, ...)
+	inline void ComposeTRSOne(T tx, T ty, T tz, T qx, T qy, T qz, T qw, T sx, T sy, T sz, T (&m)[16]) {
+		T a2 = qx*qx, b2 = qy*qy, c2 = qz*qz;
+		T ac = qx*qz, ab = qx*qy, bc = qy*qz;
+		T ad = qw*qx, bd = qw*qy, cd = qw*qz;
+		T zero = Broadcast<T>(0.0f), one = Broadcast<T>(1.0f);
+
+		m[0] = (1.0f - 2.0f*(b2 + c2))*sx; m[1] = (2.0f*(ab - cd))*sy; m[2] = (2.0f*(ac + bd))*sz;      m[3] = tx;   // Row 0: m0 m4 m8 m12
+		m[4] = (2.0f*(ab + cd))*sx;     m[5] = (1.0f - 2.0f*(a2 + c2))*sy; m[6] = (2.0f*(bc - ad))*sz;  m[7] = ty;   // Row 1: m1 m5 m9 m13
+		m[8] = (2.0f*(ac - bd))*sx;     m[9] = (2.0f*(bc + ad))*sy;  m[10] = (1.0f - 2.0f*(a2 + b2))*sz; m[11] = tz; // Row 2: m2 m6 m10 m14
+		m[12] = zero; m[13] = zero; m[14] = zero; m[15] = one;                                                     // Row 3: m3 m7 m11 m15
+	}
+
+	// Batch kernels: whole registers first, then the leftovers one at a time
+
+	inline void MultiplyMatrices(const ::Matrix* left, const ::Matrix* right, ::Matrix* out, size_t count) {
+		for(size_t i = 0; i < count; i++) {  // One matrix at a time, a whole row per register
+			const float* l = (const float*)&left[i];
+			const float* r = (const float*)&right[i];
+			Row l0 = Load<Row>(l), l1 = Load<Row>(l + 4), l2 = Load<Row>(l + 8), l3 = Load<Row>(l + 12);
+			float rs[16]; std::memcpy(rs, r, sizeof(rs));
+			float* o = (float*)&out[i];
+			for(int row = 0; row < 4; row++)  // raymath's MatrixMultiply(left, right) row by row
+				Store(o + row * 4, rs[row*4 + 0]*l0 + rs[row*4 + 1]*l1 + rs[row*4 + 2]*l2 + rs[row*4 + 3]*l3);
+		}
+	}
+
+	inline void MultiplyQuaternions(ConstFloats4 a, ConstFloats4 b, Floats4 out, size_t count) {
+		size_t i = 0;
+		for(; i + CS381_BATCH_WIDTH <= count; i += CS381_BATCH_WIDTH) {
+			Lanes x, y, z, w;
+			QuaternionMultiplyOne(Load<Lanes>(a.x + i), Load<Lanes>(a.y + i), Load<Lanes>(a.z + i), Load<Lanes>(a.w + i),
+				Load<Lanes>(b.x + i), Load<Lanes>(b.y + i), Load<Lanes>(b.z + i), Load<Lanes>(b.w + i), x, y, z, w);
+			Store(out.x + i, x); Store(out.y + i, y); Store(out.z + i, z); Store(out.w + i, w);
+		}
+		for(; i < count; i++) {
+			float x, y, z, w;
+			QuaternionMultiplyOne(a.x[i], a.y[i], a.z[i], a.w[i], b.x[i], b.y[i], b.z[i], b.w[i], x, y, z, w);
+			out.x[i] = x; out.y[i] = y; out.z[i] = z; out.w[i] = w;
+		}
+	}
+
+	inline void RotateByQuaternion(ConstFloats3 v, ConstFloats4 q, Floats3 out, size_t count) {
+		size_t i = 0;
+		for(; i + CS381_BATCH_WIDTH <= count; i += CS381_BATCH_WIDTH) {
+			Lanes x, y, z;
+			RotateOne(Load<Lanes>(v.x + i), Load<Lanes>(v.y + i), Load<Lanes>(v.z + i),
+				Load<Lanes>(q.x + i), Load<Lanes>(q.y + i), Load<Lanes>(q.z + i), Load<Lanes>(q.w + i), x, y, z);
+			Store(out.x + i, x); Store(out.y + i, y); Store(out.z + i, z);
+		}
+		for(; i < count; i++) {
+			float x, y, z;
+			RotateOne(v.x[i], v.y[i], v.z[i], q.x[i], q.y[i], q.z[i], q.w[i], x, y, z);
+			out.x[i] = x; out.y[i] = y; out.z[i] = z;
+		}
+	}
+
+	inline void Normalize3(Floats3 v, size_t count) {
+		size_t i = 0;
+		for(; i + CS381_BATCH_WIDTH <= count; i += CS381_BATCH_WIDTH) {
+			Lanes x = Load<Lanes>(v.x + i), y = Load<Lanes>(v.y + i), z = Load<Lanes>(v.z + i);
+			Normalize3One(x, y, z);
+			Store(v.x + i, x); Store(v.y + i, y); Store(v.z + i, z);
+		}
+		for(; i < count; i++)
+			Normalize3One(v.x[i], v.y[i], v.z[i]);
+	}
+
+	inline void Normalize4(Floats4 q, size_t count) {
+		size_t i = 0;
+		for(; i + CS381_BATCH_WIDTH <= count; i += CS381_BATCH_WIDTH) {
+			Lanes x = Load<Lanes>(q.x + i), y = Load<Lanes>(q.y + i), z = Load<Lanes>(q.z + i), w = Load<Lanes>(q.w + i);
+			Normalize4One(x, y, z, w);
+			Store(q.x + i, x); Store(q.y + i, y); Store(q.z + i, z); Store(q.w + i, w);
+		}
+		for(; i < count; i++)
+			Normalize4One(q.x[i], q.y[i], q.z[i], q.w[i]);
+	}
+
+	inline void ComposeTRS(ConstFloats3 t, ConstFloats4 r, ConstFloats3 s, ::Matrix* out, size_t count) {
+		size_t i = 0;
+		for(; i + CS381_BATCH_WIDTH <= count; i += CS381_BATCH_WIDTH) {
+			Lanes m[16];
+			ComposeTRSOne(Load<Lanes>(t.x + i), Load<Lanes>(t.y + i), Load<Lanes>(t.z + i),
+				Load<Lanes>(r.x + i), Load<Lanes>(r.y + i), Load<Lanes>(r.z + i), Load<Lanes>(r.w + i),
+				Load<Lanes>(s.x + i), Load<Lanes>(s.y + i), Load<Lanes>(s.z + i), m);
+			for(int lane = 0; lane < CS381_BATCH_WIDTH; lane++) {  // Transpose the lanes back out into Matrix structs
+				float* o = (float*)&out[i + lane];
+				for(int f = 0; f < 16; f++)
+					o[f] = LaneOf(m[f], lane);
+			}
+		}
+		for(; i < count; i++) {
+			float m[16];
+			ComposeTRSOne(t.x[i], t.y[i], t.z[i], r.x[i], r.y[i], r.z[i], r.w[i], s.x[i], s.y[i], s.z[i], m);
+			std::memcpy(&out[i], m, sizeof(m));
+		}
+	}
+
+	extern const Implementation implementation;
+	const Implementation implementation = {
+		CS381_BATCH_NAME, MultiplyMatrices, MultiplyQuaternions, RotateByQuaternion, Normalize3, Normalize4, ComposeTRS
+	};
+}
@@ -0,0 +1,91 @@
+#include "Bounds.hpp"
+#include <raymath.h>
+#include <cmath>
+#include "rlgl.h"
+
+namespace cs381 {
+
+	BoundingBox MeshBounds(const ::Model& model) {
+		if (model.meshCount == 0) return { { 0, 0, 0 }, { 0, 0, 0 } };
+		BoundingBox bounds = GetMeshBoundingBox(model.meshes[0]);
+		for (int i = 1; i < model.meshCount; ++i) {
+			BoundingBox mesh = GetMeshBoundingBox(model.meshes[i]);
+			bounds.min = Vector3Min(bounds.min, mesh.min);
+			bounds.max = Vector3Max(bounds.max, mesh.max);
+		}
+		return bounds;
+	}
+
+	BoundingBox TransformBounds(const BoundingBox& box, const ::Matrix& m) {
+		// Transform the center, then grow by each axis' extent through the absolute matrix (Arvo)
+		Vector3 center = Vector3Transform(Vector3Scale(Vector3Add(box.min, box.max), 0.5f), m);
+		Vector3 extent = Vector3Scale(Vector3Subtract(box.max, box.min), 0.5f);
+		Vector3 worldExtent = {
+			fabsf(m.m0) * extent.x + fabsf(m.m4) * extent.y + fabsf(m.m8) * extent.z,
+			fabsf(m.m1) * extent.x + fabsf(m.m5) * extent.y + fabsf(m.m9) * extent.z,
+			fabsf(m.m2) * extent.x + fabsf(m.m6) * extent.y + fabsf(m.m10) * extent.z
+		};
+		return { Vector3Subtract(center, worldExtent), Vector3Add(center, worldExtent) };
+	}
+
+	const ModelBounds& ModelBoundsCache::Get(const ::Model& model) {
+		auto [it, inserted] = bounds.try_emplace(&model);
+		if (inserted) {
+			BoundingBox box = MeshBounds(model);
+			Vector3 furthest = Vector3Max(Vector3Negate(box.min), box.max);  // Per axis, the corner furthest from the origin
+			furthest = Vector3Max(furthest, Vector3Negate(furthest));
+			it->second = { box, Vector3Length(furthest) };
+		}
+		return it->second;
+	}
+
+	Frustum::Frustum(const ::Matrix& m) {
+		// Clip space rows of the matrix, a point is inside when -w <= x, y, z <= w
+		Vector4 x = { m.m0, m.m4, m.m8, m.m12 };
+		Vector4 y = { m.m1, m.m5, m.m9, m.m13 };
+		Vector4 z = { m.m2, m.m6, m.m10, m.m14 };
+		Vector4 w = { m.m3, m.m7, m.m11, m.m15 };
+		auto add = [](Vector4 a, Vector4 b) { return Vector4{ a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; };
+		auto sub = [](Vector4 a, Vector4 b) { return Vector4{ a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; };
+		planes[0] = add(w, x); planes[1] = sub(w, x);  // Left, right
+		planes[2] = add(w, y); planes[3] = sub(w, y);  // Bottom, top
+		planes[4] = add(w, z); planes[5] = sub(w, z);  // Near, far
+
+		for (auto& plane : planes) {  // Normalized so sphere radii can be compared against plane distances
+			float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+			if (length > 0) plane = { plane.x / length, plane.y / length, plane.z / length, plane.w / length };
+		}
+	}
+
+	Frustum Frustum::Current() {
+		return Frustum(MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+	}
+
+	::Matrix Frustum::ViewProjection(const Camera3D& camera, float aspect) {
+		::Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+		::Matrix projection;
+		if (camera.projection == CAMERA_PERSPECTIVE) {
+			projection = MatrixPerspective(camera.fovy * DEG2RAD, aspect, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+		} else {
+			double top = camera.fovy / 2.0, right = top * aspect;
+			projection = MatrixOrtho(-right, right, -top, top, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+		}
+		return MatrixMultiply(view, projection);
+	}
+
+	bool Frustum::ContainsSphere(Vector3 c, float radius) const {
+		for (auto& p : planes) {
+			if (p.x * c.x + p.y * c.y + p.z * c.z + p.w < -radius) return false;
+		}
+		return true;
+	}
+
+	bool Frustum::ContainsBox(const BoundingBox& box) const {
+		for (auto& p : planes) {
+			// The corner furthest along the plane's normal, if even it is behind the plane the whole box is
+			Vector3 corner = { p.x >= 0 ? box.max.x : box.min.x, p.y >= 0 ? box.max.y : box.min.y, p.z >= 0 ? box.max.z : box.min.z };
+			if (p.x * corner.x + p.y * corner.y + p.z * corner.z + p.w < 0) return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+#include <raylib.h>
+#include <unordered_map>
+
+namespace cs381 {
+
+	// Model space bounds of every mesh in a model, ignoring model.transform (entities supply their own matrix)
+	// Walks every vertex, so use a ModelBoundsCache instead of calling this per frame
+	BoundingBox MeshBounds(const ::Model& model);
+
+	// World space AABB of a box moved by transform (exact for the 8 transformed corners, rotations included)
+	BoundingBox TransformBounds(const BoundingBox& box, const ::Matrix& transform);
+
+	struct ModelBounds {
+		BoundingBox box;  // Model space
+		float radius;  // Distance from the model's origin to its furthest box corner, a sphere which survives any rotation
+	};
+
+	// Bounds are computed the first time a model is asked for (ideally right after loading it) and reused after that
+	// Keyed by address, models must outlive the cache and not be reloaded in place
+	struct ModelBoundsCache {
+		const ModelBounds& Get(const ::Model& model);
+
+	protected:
+		std::unordered_map<const ::Model*, ModelBounds> bounds;
+	};
+
+	// The six clip planes of a view projection matrix (Gribb/Hartmann), normals point inwards
+	struct Frustum {
+		Vector4 planes[6];  // xyz normal, w distance: inside when dot(normal, p) + w >= 0
+
+		Frustum(const ::Matrix& viewProjection);
+		static Frustum Current();  // From rlgl's modelview and projection, call between BeginMode3D and EndMode3D
+		static ::Matrix ViewProjection(const Camera3D& camera, float aspect);  // The matrices BeginMode3D would set, usable without a window
+
+		bool ContainsSphere(Vector3 center, float radius) const;  // False only if the sphere is entirely outside
+		bool ContainsBox(const BoundingBox& box) const;  // False only if the box is entirely outside
+	};
+}
+
+#endif // BOUNDS_HPP
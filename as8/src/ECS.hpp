@@ -11,6 +11,9 @@
 #include <span>
 #include <variant>
 #include <cassert>
+#include <algorithm>
+#include <limits>
+#include <tuple>
 
 extern size_t globalComponentCounter;
 
@@ -22,7 +25,7 @@ namespace cs381 {
 		return id;  // Return unique component ID
 	}
 
-	using Entity = uint8_t;  // Alias for entity type, used for representing entities as uint8_t
+	using Entity = uint32_t;  // Alias for entity type, used for representing entities as uint32_t
 
 	// ComponentStorage structure handles storing components of entities
 	struct ComponentStorage {
@@ -45,7 +48,6 @@ namespace cs381 {
 		template<typename Tcomponent>  // Function to allocate memory for components
 		std::pair<Tcomponent&, size_t> Allocate(size_t count = 1) {
 			assert(sizeof(Tcomponent) == elementSize);  // Ensure element size matches
-			assert(count < 100);  // Ensure count is reasonable
 			auto originalEnd = data.size();  // Save the current size of data
 			data.insert(data.end(), elementSize * count, std::byte{0});  // Insert space for components
 			for(size_t i = 0; i < count - 1; i++)  // Initialize all but the last component
@@ -66,17 +68,21 @@ namespace cs381 {
 		}
 	};
 
+	template<typename Storage, typename... Tcomponents>
+	struct BasicSceneView;
+
 	// Scene structure manages entities and their components
 	template<typename Storage = ComponentStorage>  // Default to using ComponentStorage for the component data
 	struct Scene {
 		std::vector<std::vector<bool>> entityMasks;  // Masks to track components for each entity
+		std::vector<std::vector<Entity>> componentEntities;  // For each component ID, the entities which have it (ascending), views walk these instead of every mask
 		std::vector<Storage> storages = {Storage()};  // Vector of component storages
 
 		template<typename Tcomponent>  // Get the storage for a specific component
 		Storage& GetStorage() {
 			size_t id = GetComponentID<Tcomponent>();  // Get the component ID
 			if(storages.size() <= id)  // If storage is not large enough, add more
-				storages.insert(storages.cend(), std::max<int64_t>(id - storages.size(), 1), Storage());
+				storages.resize(id + 1, Storage());
 			if (storages[id].elementSize == std::numeric_limits<size_t>::max())  // If element size is uninitialized, initialize it
 				storages[id] = Storage(Tcomponent{});
 			return storages[id];  // Return the storage for the component
@@ -90,20 +96,13 @@ namespace cs381 {
 
 		template<typename Tcomponent>  // Add a component to an entity
 		Tcomponent& AddComponent(Entity e) {
-			size_t id = GetComponentID<Tcomponent>();  // Get component ID
-			auto& eMask = entityMasks[e];  // Get the entity's mask
-			if(eMask.size() <= id)  // If the mask is too small, resize it
-				eMask.resize(id + 1, false);
-			eMask[id] = true;  // Set the component bit in the mask
+			SetMask(e, GetComponentID<Tcomponent>(), true);  // Set the component bit in the mask
 			return GetStorage<Tcomponent>().template GetOrAllocate<Tcomponent>(e);  // Return the component
 		}
 
 		template<typename Tcomponent>  // Remove a component from an entity
 		void RemoveComponent(Entity e) {
-			size_t id = GetComponentID<Tcomponent>();  // Get component ID
-			auto& eMask = entityMasks[e];  // Get the entity's mask
-			if(eMask.size() > id)  // If the component exists, remove it from the mask
-				eMask[id] = false;
+			SetMask(e, GetComponentID<Tcomponent>(), false);  // If the component exists, remove it from the mask
 		}
 
 		template<typename Tcomponent>  // Get a component from an entity
@@ -118,6 +117,30 @@ namespace cs381 {
 			size_t id = GetComponentID<Tcomponent>();  // Get component ID
 			return entityMasks[e].size() > id && entityMasks[e][id];  // Check if component bit is set in the mask
 		}
+
+		template<typename... Tcomponents>  // View over every entity which has all of the given components
+		BasicSceneView<Storage, Tcomponents...> View() { return {*this}; }
+
+	protected:
+		void SetMask(Entity e, size_t id, bool value) {  // Set or clear a component bit in an entity's mask
+			auto& eMask = entityMasks[e];  // Get the entity's mask
+			if(eMask.size() <= id) {  // If the mask is too small, resize it (clearing a bit it doesn't have is a no-op)
+				if(!value) return;
+				eMask.resize(id + 1, false);
+			}
+			if(eMask[id] == value) return;
+			eMask[id] = value;
+			ListEntity(e, id, value);
+		}
+
+		void ListEntity(Entity e, size_t id, bool value) {  // Add or remove an entity in a component's entity list, keeping it sorted
+			if(componentEntities.size() <= id)
+				componentEntities.resize(id + 1);
+			auto& list = componentEntities[id];
+			if(value && (list.empty() || list.back() < e)) list.push_back(e);  // Components are mostly added in creation order
+			else if(value) list.insert(std::lower_bound(list.begin(), list.end(), e), e);
+			else list.erase(std::lower_bound(list.begin(), list.end(), e));
+		}
 	};
 
 	// SkiplistComponentStorage is an alternative storage for components that uses a skiplist for indexing
@@ -171,43 +194,62 @@ namespace cs381 {
 	using post_increment_t = int;  // Alias for post-increment type used in iterators
 
 	// SceneView is a view into the scene for iterating over entities with specific components
-	template<typename... Tcomponents>  // Template for multiple component types
-	struct SceneView {
-		Scene<SkiplistComponentStorage>& scene;  // Reference to the scene
+	// Only the entities which have the view's rarest component are visited (from the scene's per component lists, in
+	// ascending order), each is then checked for the rest, so entities without the components cost nothing
+	template<typename Storage, typename... Tcomponents>  // Template for the scene's storage and multiple component types
+	struct BasicSceneView {
+		Scene<Storage>& scene;  // Reference to the scene
 
 		struct Sentinel {};  // Sentinel type to mark the end of an iterator
 		struct Iterator {  // Iterator type for iterating over entities
-			Scene<SkiplistComponentStorage>* scene = nullptr;  // Pointer to the scene
-			Entity e;  // Current entity
+			Scene<Storage>* scene = nullptr;  // Pointer to the scene
+			const std::vector<Entity>* candidates = nullptr;  // Entities with the rarest of the components
+			size_t index = 0;  // Current position in candidates
 
-			bool valid() { return (scene->HasComponent<Tcomponents>(e) && ...); }  // Check if entity has all required components
+			bool valid() { return (scene->template HasComponent<Tcomponents>(entity()) && ...); }  // Check if entity has all required components
 
-			bool operator==(Sentinel) { return scene == nullptr || e >= scene->entityMasks.size(); }  // Check if iterator reached the end
+			bool operator==(Sentinel) { return candidates == nullptr || index >= candidates->size(); }  // Check if iterator reached the end
 
-			Iterator& operator++(post_increment_t) {  // Post-increment operator for iterator
+			Iterator& operator++() {  // Pre-increment operator for iterator
 				do {
-					e++;  // Move to the next entity
-				} while(!valid() && e < scene->entityMasks.size());  // Skip invalid entities
+					index++;  // Move to the next candidate
+				} while(index < candidates->size() && !valid());  // Skip candidates missing other components (checking the bounds first)
 				return *this;
 			}
 
-			Iterator operator++() {  // Pre-increment operator for iterator
-				Iterator old;
-				operator++(0);  // Call post-increment
+			Iterator operator++(post_increment_t) {  // Post-increment operator for iterator
+				Iterator old = *this;
+				++*this;
 				return old;  // Return the old iterator
 			}
 
-			// std::tuple<std::add_lvalue_reference_t<Tcomponents>...> operator*() { return { scene->GetComponent<Tcomponents>(e)... }; }  // Access components of entity
-			std::tuple<std::add_lvalue_reference_t<Tcomponents>...> operator*() { return { scene->GetComponent<Tcomponents>(e)... }; }  // Dereference iterator to get components
+			Entity entity() const { return (*candidates)[index]; }  // The entity the iterator is on
+
+			std::tuple<std::add_lvalue_reference_t<Tcomponents>...> operator*() { return { scene->template GetComponent<Tcomponents>(entity())... }; }  // Dereference iterator to get components
 		};
 
 		Iterator begin() {  // Get the iterator for the beginning of the view
-			Iterator out{&scene, 0};  // Create iterator starting at entity 0
-			if(!out.valid()) ++out;  // Skip invalid entities
+			static const std::vector<Entity> none;
+			const std::vector<Entity>* rarest = nullptr;
+			for(size_t id : {GetComponentID<Tcomponents>()...}) {  // Pick the shortest entity list
+				const std::vector<Entity>& list = id < scene.componentEntities.size() ? scene.componentEntities[id] : none;
+				if(!rarest || list.size() < rarest->size()) rarest = &list;
+			}
+			Iterator out{&scene, rarest, 0};  // Create iterator starting at the first candidate
+			if(out != Sentinel{} && !out.valid()) ++out;  // Skip invalid entities
 			return out;  // Return iterator
 		}
 		Sentinel end() { return {}; }  // Return the sentinel for the end of the view
+
+		template<typename F>  // Call f(entity, components...) for every matching entity
+		void ForEach(F&& f) {
+			for(auto it = begin(); it != end(); ++it)
+				std::apply([&](auto&&... components) { f(it.entity(), std::forward<decltype(components)>(components)...); }, *it);
+		}
 	};
+
+	template<typename... Tcomponents>  // View into the default skiplist backed scene
+	using SceneView = BasicSceneView<SkiplistComponentStorage, Tcomponents...>;
 }
 
 #endif // ECS_HPP
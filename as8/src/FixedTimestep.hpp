@@ -0,0 +1,44 @@
+#ifndef FIXED_TIMESTEP_HPP
+#define FIXED_TIMESTEP_HPP
+
+#include <algorithm>
+#include <cmath>
+
+namespace cs381 {
+
+	// FixedTimestep decouples the simulation rate from the render rate
+	// Each frame the frame time is added to an accumulator, which is then spent in whole simulation ticks
+	// The leftover fraction of a tick (Alpha) is used to interpolate between the last two simulated states when drawing
+	struct FixedTimestep {
+		float tickRate = 60.0f;  // Simulation ticks per second
+		int maxCatchUpSteps = 5;  // Most ticks run in a single frame, after a long frame the remaining backlog is dropped
+		float accumulator = 0.0f;  // Time which has passed but not been simulated yet
+
+		FixedTimestep() = default;
+		FixedTimestep(float tickRate, int maxCatchUpSteps = 5) : tickRate(tickRate), maxCatchUpSteps(maxCatchUpSteps) {}
+
+		float StepSize() const { return 1.0f / tickRate; }  // Length of a single simulation tick
+
+		int Advance(float frameTime) {  // Add a frame's worth of time and return how many ticks to simulate
+			float step = StepSize();
+			accumulator += std::max(frameTime, 0.0f);
+			int steps = std::min<int>(accumulator / step, maxCatchUpSteps);  // Never spiral trying to catch up
+			accumulator -= steps * step;
+			if(steps == maxCatchUpSteps)  // We fell behind, forget the backlog (the game slows down instead of freezing)
+				accumulator = std::min(accumulator, step);
+			return steps;
+		}
+
+		float Alpha() const { return std::clamp(accumulator / StepSize(), 0.0f, 1.0f); }  // How far between the previous and current tick we are
+	};
+
+	// Interpolates between two angles in degrees the short way around, so 350 to 10 turns 20 degrees instead of -340
+	inline float LerpDegrees(float from, float to, float alpha) {
+		float delta = std::fmod(to - from, 360.0f);
+		if(delta > 180) delta -= 360;
+		else if(delta < -180) delta += 360;
+		return from + delta * alpha;
+	}
+}
+
+#endif // FIXED_TIMESTEP_HPP
@@ -0,0 +1,179 @@
+#include "Impostor.hpp"
+#include <raymath.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "rlgl.h"
+
+namespace cs381 {
+
+	constexpr float framePadding = 1.05f;  // Keeps silhouettes off the cell edges, where mipmaps would bleed them into the next cell
+	constexpr uint32_t bakeVersion = 1;  // Bump when Bake changes, so every cached atlas is baked again
+
+	// FNV-1a over everything which decides what Bake draws and can be read without drawing it
+	static uint64_t CacheKey(const ::Model& model, const BoundingBox& bounds, int views, int cellSize) {
+		uint64_t hash = 14695981039346656037ull;
+		auto mix = [&hash](const auto& value) {
+			unsigned char bytes[sizeof(value)];
+			std::memcpy(bytes, &value, sizeof(value));
+			for (unsigned char byte : bytes) hash = (hash ^ byte) * 1099511628211ull;
+		};
+		mix(bakeVersion); mix(views); mix(cellSize); mix(framePadding);
+		mix(bounds.min.x); mix(bounds.min.y); mix(bounds.min.z);
+		mix(bounds.max.x); mix(bounds.max.y); mix(bounds.max.z);
+		mix(model.meshCount);
+		for (int m = 0; m < model.meshCount; ++m) {
+			mix(model.meshes[m].vertexCount);
+			mix(model.meshes[m].triangleCount);
+		}
+		return hash;
+	}
+
+	ImpostorAtlas::ImpostorAtlas(const ::Model& model, const BoundingBox& bounds, const std::string& cacheName, int views, int cellSize)
+		: views(std::max(views, 1)), columns((int)ceilf(sqrtf((float)std::max(views, 1)))), cellSize(cellSize) {
+		center = Vector3Scale(Vector3Add(bounds.min, bounds.max), 0.5f);
+		halfSize = Vector3Distance(bounds.min, bounds.max) * 0.5f * framePadding;
+		cachePath = cacheName + TextFormat("_impostor_%016llx.png", (unsigned long long)CacheKey(model, bounds, this->views, cellSize));
+
+		int size = columns * cellSize;
+		if (FileExists(cachePath.c_str())) {
+			::Image image = LoadImage(cachePath.c_str());
+			if (image.width == size && image.height == size) {  // Guards against a truncated or hand edited file
+				texture = LoadTextureFromImage(image);
+				cached = true;
+			}
+			UnloadImage(image);
+		}
+		if (!cached) {
+			Bake(model);
+			::Image image = LoadImageFromTexture(texture);
+			ExportImage(image, cachePath.c_str());  // Only an optimization, a read only directory just means baking every run
+			UnloadImage(image);
+		}
+
+		GenTextureMipmaps(&texture);
+		SetTextureFilter(texture, TEXTURE_FILTER_TRILINEAR);
+		SetTextureWrap(texture, TEXTURE_WRAP_CLAMP);
+	}
+
+	void ImpostorAtlas::Bake(const ::Model& model) {
+		RenderTexture2D target = LoadRenderTexture(columns * cellSize, columns * cellSize);
+		BeginTextureMode(target);
+		ClearBackground(BLANK);
+		for (int view = 0; view < views; ++view) {
+			float yaw = 2 * PI * view / views;
+			Vector3 direction = { sinf(yaw), 0, cosf(yaw) };
+			// Orthographic, fovy is the height of the view, the camera backs off far enough to keep the whole sphere past the near plane
+			::Camera3D camera = { Vector3Add(center, Vector3Scale(direction, halfSize * 2)), center, { 0, 1, 0 }, halfSize * 2, CAMERA_ORTHOGRAPHIC };
+
+			rlViewport((view % columns) * cellSize, (view / columns) * cellSize, cellSize, cellSize);
+			BeginMode3D(camera);
+			for (int m = 0; m < model.meshCount; ++m)
+				DrawMesh(model.meshes[m], model.materials[model.meshMaterial[m]], MatrixIdentity());
+			EndMode3D();
+		}
+		EndTextureMode();
+
+		// Copied out so the framebuffer and its depth buffer can go
+		::Image image = LoadImageFromTexture(target.texture);
+		texture = LoadTextureFromImage(image);
+		UnloadImage(image);
+		UnloadRenderTexture(target);
+	}
+
+	int ImpostorAtlas::View(Vector3 toEye) const {
+		float yaw = atan2f(toEye.x, toEye.z);  // Same angle Bake places the cameras at
+		int view = (int)roundf(yaw / (2 * PI) * views) % views;
+		return view < 0 ? view + views : view;
+	}
+
+	::Matrix ImpostorAtlas::Billboard(Vector3 position, Quaternion rotation, Vector3 scale, Vector3 eye) const {
+		Vector3 worldCenter = Vector3Add(position, Vector3RotateByQuaternion(Vector3Multiply(center, scale), rotation));
+		Vector3 toEye = Vector3Subtract(eye, worldCenter);
+		int view = View(Vector3RotateByQuaternion(toEye, QuaternionInvert(rotation)));
+
+		Vector3 forward = { toEye.x, 0, toEye.z };
+		float length = Vector3Length(forward);
+		forward = length > 0 ? Vector3Scale(forward, 1 / length) : Vector3{ 0, 0, 1 };  // Straight above, any direction will do
+		Vector3 right = { forward.z, 0, -forward.x };  // Up cross forward, the bake cameras' right
+		float side = 2 * halfSize * std::max({ fabsf(scale.x), fabsf(scale.y), fabsf(scale.z) });
+
+		::Matrix matrix = {};
+		matrix.m0 = right.x * side; matrix.m1 = 0; matrix.m2 = right.z * side;
+		matrix.m5 = side;
+		matrix.m8 = forward.x; matrix.m10 = forward.z;
+		matrix.m12 = worldCenter.x; matrix.m13 = worldCenter.y; matrix.m14 = worldCenter.z; matrix.m15 = 1;
+		// The cell's corner and size in texture coordinates, where an affine matrix has zeros
+		matrix.m3 = (float)(view % columns) / columns;
+		matrix.m7 = (float)(view / columns) / columns;
+		matrix.m11 = 1.0f / columns;
+		return matrix;
+	}
+
+	ImpostorRenderer::~ImpostorRenderer() {
+		for (auto& bucket : buckets)
+			MemFree(bucket.material.maps);  // UnloadMaterial would also unload the shader and the atlas, which aren't the bucket's
+		if (quad.vertices) UnloadMesh(quad);
+	}
+
+	ImpostorRenderer& ImpostorRenderer::Init() {
+		shader = raylib::Shader::LoadFromMemory(vertexShader, fragmentShader);
+		// DrawMeshInstanced binds the per instance matrices to the model matrix location, so point it at the attribute
+		if (shader.id != rlGetShaderIdDefault())
+			shader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(shader, "instanceTransform");
+
+		quad.vertexCount = 4;
+		quad.triangleCount = 2;
+		quad.vertices = (float*)MemAlloc(4 * 3 * sizeof(float));
+		quad.texcoords = (float*)MemAlloc(4 * 2 * sizeof(float));
+		quad.indices = (unsigned short*)MemAlloc(6 * sizeof(unsigned short));
+		const float corners[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+		for (int i = 0; i < 4; ++i) {
+			quad.vertices[i * 3] = corners[i][0] - 0.5f;
+			quad.vertices[i * 3 + 1] = corners[i][1] - 0.5f;
+			quad.vertices[i * 3 + 2] = 0;
+			quad.texcoords[i * 2] = corners[i][0];
+			quad.texcoords[i * 2 + 1] = corners[i][1];
+		}
+		const unsigned short indices[6] = { 0, 1, 2, 0, 2, 3 };  // Counter clockwise seen from +Z
+		std::copy_n(indices, 6, quad.indices);
+		UploadMesh(&quad, false);
+		return *this;
+	}
+
+	bool ImpostorRenderer::Supported() const {
+		// A shader which fails to compile (no GL 3.3) falls back to raylib's default shader, which can't read the atlas cell
+		return shader.id > 0 && shader.id != rlGetShaderIdDefault() && shader.locs[SHADER_LOC_MATRIX_MODEL] >= 0;
+	}
+
+	ImpostorRenderer& ImpostorRenderer::Begin() {
+		for (auto& bucket : buckets) bucket.transforms.clear();
+		return *this;
+	}
+
+	void ImpostorRenderer::Submit(const ImpostorAtlas& atlas, Vector3 position, Quaternion rotation, Vector3 scale, Vector3 eye) {
+		auto [it, inserted] = bucketIndex.try_emplace(&atlas, buckets.size());
+		if (inserted) {
+			::Material material = LoadMaterialDefault();
+			material.shader = shader;
+			material.maps[MATERIAL_MAP_DIFFUSE].texture = atlas.texture;
+			buckets.push_back({ &atlas, material, {} });
+		}
+		buckets[it->second].transforms.push_back(atlas.Billboard(position, rotation, scale, eye));
+	}
+
+	ImpostorRenderer& ImpostorRenderer::Enqueue(RenderQueue& queue, Vector3 eye) {
+		stats = {};
+		for (auto& bucket : buckets) {
+			if (bucket.transforms.empty()) continue;
+			float nearest = INFINITY;  // Squared, like InstancedRenderer's keys
+			for (auto& transform : bucket.transforms)
+				nearest = std::min(nearest, Vector3DistanceSqr({ transform.m12, transform.m13, transform.m14 }, eye));
+			queue.Add(RenderQueue::Opaque, quad, bucket.material, bucket.transforms, nearest, true);
+			stats.drawCalls++;
+			stats.impostors += bucket.transforms.size();
+		}
+		return *this;
+	}
+}
@@ -0,0 +1,89 @@
+#ifndef IMPOSTOR_HPP
+#define IMPOSTOR_HPP
+
+#include "raylib-cpp.hpp"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "RenderQueue.hpp"
+
+namespace cs381 {
+
+	// Pictures of a model taken from views directions around it, for drawing it as a single textured quad when it is far away
+	// The views are evenly spaced around the model's up axis, level with its center, and each is drawn orthographically into
+	// one cell of a square grid in the atlas texture. Every cell frames the same sphere around the model's bounds, so any
+	// cell can be shown on the same quad
+	// Atlases are baked when created and saved as <cacheName>_impostor_<key>.png, later runs load that file instead. The key
+	// hashes everything the bake depends on which can be checked without baking (views, cell size, bounds, mesh and vertex
+	// counts), so a changed model gets a new file. Material or texture edits which keep the geometry aren't noticed
+	// The image is stored bottom row first (as OpenGL reads it back), so the cached file looks upside down in a viewer
+	struct ImpostorAtlas {
+		int views;
+		int columns;  // Cells per side of the grid
+		int cellSize;  // Pixels per side of a cell
+		Vector3 center;  // Model space center of the framed sphere
+		float halfSize;  // Model space radius of the framed sphere, half the quad's side
+		std::string cachePath;
+		bool cached = false;  // Loaded from cachePath instead of baked
+		::Texture2D texture = {};
+
+		// Needs the window to exist. The model's own transform is ignored, like InstancedRenderer does
+		ImpostorAtlas(const ::Model& model, const BoundingBox& bounds, const std::string& cacheName, int views = 16, int cellSize = 128);
+		ImpostorAtlas(const ImpostorAtlas&) = delete;
+		~ImpostorAtlas() { if (texture.id > 0) UnloadTexture(texture); }
+
+		int View(Vector3 toEye) const;  // The view closest to looking along -toEye, toEye in model space
+
+		// Instance matrix of the quad showing a model at (position, rotation, scale) to a camera at eye
+		// The quad is centered on the model and turned to face the eye around the world's up axis, the cell to show is
+		// packed into its bottom row (see impostor.vs)
+		::Matrix Billboard(Vector3 position, Quaternion rotation, Vector3 scale, Vector3 eye) const;
+
+	protected:
+		void Bake(const ::Model& model);
+	};
+
+	// Collects impostor quads per atlas and adds one instanced draw per atlas to a RenderQueue
+	// Quads are alpha tested against the atlas, so they are drawn with the opaque geometry and write depth
+	struct ImpostorRenderer {
+		constexpr static std::string_view vertexShader =
+			#include "../generated/impostor.vs"
+		;
+		constexpr static std::string_view fragmentShader =
+			#include "../generated/impostor.fs"
+		;
+
+		struct Stats {
+			size_t drawCalls = 0;
+			size_t impostors = 0;  // Quads drawn
+		};
+
+		Stats stats;  // Of the last Enqueue
+
+		ImpostorRenderer() : shader(0) {}
+		ImpostorRenderer(const ImpostorRenderer&) = delete;
+		~ImpostorRenderer();
+
+		ImpostorRenderer& Init();  // Loads the shader and the quad, needs the window to exist
+		bool Supported() const;  // Impostors can only be drawn when this is true, draw the models instead otherwise
+
+		ImpostorRenderer& Begin();  // Forget last frame's quads
+		void Submit(const ImpostorAtlas& atlas, Vector3 position, Quaternion rotation, Vector3 scale, Vector3 eye);
+		ImpostorRenderer& Enqueue(RenderQueue& queue, Vector3 eye);  // The matrices stay valid until the next Begin
+
+	protected:
+		struct Bucket {
+			const ImpostorAtlas* atlas;
+			::Material material;  // Own maps, with the impostor shader and the atlas texture
+			std::vector<::Matrix> transforms;
+		};
+
+		raylib::Shader shader;
+		::Mesh quad = {};  // Unit square on the XY plane, facing +Z
+		std::vector<Bucket> buckets;  // Emptied but kept between frames
+		std::unordered_map<const ImpostorAtlas*, size_t> bucketIndex;
+	};
+}
+
+#endif // IMPOSTOR_HPP
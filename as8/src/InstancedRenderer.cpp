@@ -0,0 +1,96 @@
+#include "InstancedRenderer.hpp"
+#include <algorithm>
+#include "rlgl.h"
+
+namespace cs381 {
+
+	InstancedRenderer& InstancedRenderer::Init() {
+		shader = raylib::Shader::LoadFromMemory(vertexShader, fragmentShader);
+		// DrawMeshInstanced binds the per instance matrices to the model matrix location, so point it at the attribute
+		if (shader.id != rlGetShaderIdDefault())
+			shader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(shader, "instanceTransform");
+		return *this;
+	}
+
+	bool InstancedRenderer::Supported() const {
+		// A shader which fails to compile (no GL 3.3) falls back to raylib's default shader
+		return shader.id > 0 && shader.id != rlGetShaderIdDefault() && shader.locs[SHADER_LOC_MATRIX_MODEL] >= 0;
+	}
+
+	void InstancedRenderer::Bucket::Own() {
+		transforms.insert(transforms.end(), borrowed.begin(), borrowed.end());
+		borrowed = {};
+	}
+
+	InstancedRenderer::Bucket& InstancedRenderer::BucketFor(const ::Model& model) {
+		auto [it, inserted] = bucketIndex.try_emplace(&model, buckets.size());
+		if (inserted) buckets.push_back({ &model, {}, {} });
+		return buckets[it->second];
+	}
+
+	void InstancedRenderer::Submit(const ::Model& model, const ::Matrix& transform) {
+		Bucket& bucket = BucketFor(model);
+		bucket.Own();
+		bucket.transforms.push_back(transform);
+	}
+
+	void InstancedRenderer::Submit(const ::Model& model, std::span<const ::Matrix> transforms) {
+		if (transforms.empty()) return;
+		Bucket& bucket = BucketFor(model);
+		if (bucket.borrowed.empty() && bucket.transforms.empty()) {
+			bucket.borrowed = transforms;
+			return;
+		}
+		bucket.Own();
+		bucket.transforms.insert(bucket.transforms.end(), transforms.begin(), transforms.end());
+	}
+
+	InstancedRenderer& InstancedRenderer::Begin() {
+		for (auto& bucket : buckets) {
+			bucket.borrowed = {};
+			bucket.transforms.clear();
+		}
+		return *this;
+	}
+
+	InstancedRenderer& InstancedRenderer::Enqueue(RenderQueue& queue, Vector3 eye) {
+		stats.Reset();
+		for (auto& bucket : buckets)
+			EnqueueBucket(queue, bucket, eye);
+		return *this;
+	}
+
+	static float DistanceSqr(const ::Matrix& transform, Vector3 eye) {
+		float x = transform.m12 - eye.x, y = transform.m13 - eye.y, z = transform.m14 - eye.z;
+		return x * x + y * y + z * z;
+	}
+
+	void InstancedRenderer::EnqueueBucket(RenderQueue& queue, const Bucket& bucket, Vector3 eye) {
+		const ::Model& model = *bucket.model;
+		std::span<const ::Matrix> transforms = bucket.Transforms();
+		size_t count = transforms.size();
+		if (count == 0) return;
+		bool instanced = instancing && count > 1 && Supported();  // A single instance is cheaper as a plain DrawMesh
+
+		// An instanced draw is sorted by its nearest instance
+		float nearest = DistanceSqr(transforms[0], eye);
+		if (instanced)
+			for (auto& transform : transforms) nearest = std::min(nearest, DistanceSqr(transform, eye));
+
+		for (int m = 0; m < model.meshCount; ++m) {
+			const ::Mesh& mesh = model.meshes[m];
+			::Material material = model.materials[model.meshMaterial[m]];
+			if (instanced) {
+				material.shader = shader;
+				queue.Add(RenderQueue::Opaque, mesh, material, transforms, nearest);
+				stats.drawCalls++;
+			} else {
+				for (size_t i = 0; i < count; ++i)
+					queue.Add(RenderQueue::Opaque, mesh, material, transforms.subspan(i, 1), DistanceSqr(transforms[i], eye));
+				stats.drawCalls += count;
+			}
+			stats.triangles += (size_t)mesh.triangleCount * count;
+		}
+		stats.instances += count;
+	}
+}
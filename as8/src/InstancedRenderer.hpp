@@ -0,0 +1,68 @@
+#ifndef INSTANCED_RENDERER_HPP
+#define INSTANCED_RENDERER_HPP
+
+#include "raylib-cpp.hpp"
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "RenderQueue.hpp"
+
+namespace cs381 {
+
+	struct RenderStats {
+		size_t drawCalls = 0;  // DrawMesh + DrawMeshInstanced calls
+		size_t instances = 0;  // Models drawn
+		size_t triangles = 0;
+
+		void Reset() { *this = {}; }
+	};
+
+	// Entities submit (model, world matrix) pairs instead of drawing, submissions are bucketed by model and Enqueue then
+	// adds one instanced draw per mesh of each model to a RenderQueue, so draw calls scale with distinct models instead of entities
+	// The model's own transform is ignored (the entity matrix replaces it), and models are never modified
+	// When instancing is turned off or unsupported (the shader failed to build) every instance gets its own DrawMesh
+	struct InstancedRenderer {
+		constexpr static std::string_view vertexShader =
+			#include "../generated/instancing.vs"
+		;
+		constexpr static std::string_view fragmentShader =
+			#include "../generated/instancing.fs"
+		;
+
+		bool instancing = true;  // Runtime toggle for the fallback path
+		RenderStats stats;  // Totals of the last Enqueue
+
+		InstancedRenderer() : shader(0) {}
+		InstancedRenderer(const InstancedRenderer&) = delete;
+
+		InstancedRenderer& Init();  // Loads the instancing shader, needs the window to exist
+		bool Supported() const;
+
+		InstancedRenderer& Begin();  // Forget last frame's submissions (their matrices stay valid until this is called)
+		void Submit(const ::Model& model, const ::Matrix& transform);
+		// Submits a whole range of instances without copying them, the matrices must stay valid until the queue is submitted
+		// Submitting a model as one contiguous range is what lets its instanced draw read the caller's array directly
+		void Submit(const ::Model& model, std::span<const ::Matrix> transforms);
+		InstancedRenderer& Enqueue(RenderQueue& queue, Vector3 eye);  // Adds this frame's draws, eye is the camera position used for front to back sorting
+
+	protected:
+		struct Bucket {
+			const ::Model* model;
+			std::span<const ::Matrix> borrowed;  // A single range submitted by the caller, used in place
+			std::vector<::Matrix> transforms;  // Copies, once the model was submitted more than once
+
+			std::span<const ::Matrix> Transforms() const { return borrowed.empty() ? std::span<const ::Matrix>(transforms) : borrowed; }
+			void Own();  // Copies the borrowed range so more transforms can be appended
+		};
+
+		raylib::Shader shader;
+		std::vector<Bucket> buckets;  // Emptied but kept between frames so steady state frames don't allocate
+		std::unordered_map<const ::Model*, size_t> bucketIndex;
+
+		Bucket& BucketFor(const ::Model& model);
+		void EnqueueBucket(RenderQueue& queue, const Bucket& bucket, Vector3 eye);
+	};
+}
+
+#endif // INSTANCED_RENDERER_HPP
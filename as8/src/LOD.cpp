@@ -0,0 +1,126 @@
+#include "LOD.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace cs381 {
+
+	::Mesh SimplifyMesh(const ::Mesh& mesh, int cellsPerAxis) {
+		::Mesh out = {};
+		if (mesh.vertexCount == 0 || cellsPerAxis < 1) return out;
+
+		BoundingBox bounds = GetMeshBoundingBox(mesh);
+		Vector3 size = Vector3Subtract(bounds.max, bounds.min);
+		float cell = std::max({ size.x, size.y, size.z }) / cellsPerAxis;
+		if (cell <= 0) return out;
+
+		// Cluster key: grid cell, plus the texture coordinate rounded to the palette (Kenney models pick colors from a
+		// small color map, merging across colors would smear them)
+		auto key = [&](int v) {
+			const float* p = mesh.vertices + v * 3;
+			uint64_t x = (p[0] - bounds.min.x) / cell, y = (p[1] - bounds.min.y) / cell, z = (p[2] - bounds.min.z) / cell;
+			uint64_t uv = 0;
+			if (mesh.texcoords) {
+				uint64_t u = (int)(mesh.texcoords[v * 2] * 32) & 0xFF, w = (int)(mesh.texcoords[v * 2 + 1] * 32) & 0xFF;
+				uv = u | w << 8;
+			}
+			return (x & 0xFFF) | (y & 0xFFF) << 12 | (z & 0xFFF) << 24 | uv << 36;
+		};
+
+		// Every cluster's position is the average of its vertices, other attributes come from its first vertex
+		std::unordered_map<uint64_t, int> clusters;
+		std::vector<int> remap(mesh.vertexCount), first;
+		std::vector<Vector3> sums;
+		std::vector<int> counts;
+		for (int v = 0; v < mesh.vertexCount; ++v) {
+			auto [it, inserted] = clusters.try_emplace(key(v), (int)first.size());
+			if (inserted) {
+				first.push_back(v);
+				sums.push_back({ 0, 0, 0 });
+				counts.push_back(0);
+			}
+			remap[v] = it->second;
+			sums[it->second] = Vector3Add(sums[it->second], { mesh.vertices[v * 3], mesh.vertices[v * 3 + 1], mesh.vertices[v * 3 + 2] });
+			counts[it->second]++;
+		}
+		if (first.size() > std::numeric_limits<unsigned short>::max()) return out;
+
+		std::vector<unsigned short> indices;
+		for (int t = 0; t < mesh.triangleCount; ++t) {
+			int a = remap[mesh.indices ? mesh.indices[t * 3] : t * 3];
+			int b = remap[mesh.indices ? mesh.indices[t * 3 + 1] : t * 3 + 1];
+			int c = remap[mesh.indices ? mesh.indices[t * 3 + 2] : t * 3 + 2];
+			if (a == b || b == c || a == c) continue;  // Collapsed into a line or point
+			indices.insert(indices.end(), { (unsigned short)a, (unsigned short)b, (unsigned short)c });
+		}
+		if (indices.empty()) return out;
+
+		out.vertexCount = first.size();
+		out.triangleCount = indices.size() / 3;
+		out.vertices = (float*)MemAlloc(out.vertexCount * 3 * sizeof(float));
+		if (mesh.texcoords) out.texcoords = (float*)MemAlloc(out.vertexCount * 2 * sizeof(float));
+		if (mesh.normals) out.normals = (float*)MemAlloc(out.vertexCount * 3 * sizeof(float));
+		if (mesh.colors) out.colors = (unsigned char*)MemAlloc(out.vertexCount * 4);
+		for (int i = 0; i < out.vertexCount; ++i) {
+			Vector3 average = Vector3Scale(sums[i], 1.0f / counts[i]);
+			std::memcpy(out.vertices + i * 3, &average, sizeof(average));
+			if (out.texcoords) std::memcpy(out.texcoords + i * 2, mesh.texcoords + first[i] * 2, 2 * sizeof(float));
+			if (out.normals) std::memcpy(out.normals + i * 3, mesh.normals + first[i] * 3, 3 * sizeof(float));
+			if (out.colors) std::memcpy(out.colors + i * 4, mesh.colors + first[i] * 4, 4);
+		}
+		out.indices = (unsigned short*)MemAlloc(indices.size() * sizeof(unsigned short));
+		std::memcpy(out.indices, indices.data(), indices.size() * sizeof(unsigned short));
+		return out;
+	}
+
+	LODGroup::~LODGroup() {
+		for (auto& model : generated) {
+			for (int m = 0; m < model.meshCount; ++m) UnloadMesh(model.meshes[m]);
+			MemFree(model.meshes);
+			MemFree(model.meshMaterial);  // Materials belong to the original model
+		}
+	}
+
+	LODGroup& LODGroup::AddLevel(float screenSize, const std::string& path, int cellsPerAxis) {
+		if (!path.empty() && FileExists(path.c_str())) {
+			loaded.emplace_back(path);
+			levels.push_back({ &loaded.back(), screenSize, Triangles(loaded.back()) });
+			return *this;
+		}
+
+		const ::Model& base = Model(0);
+		::Model model = base;
+		model.meshes = (::Mesh*)MemAlloc(base.meshCount * sizeof(::Mesh));
+		model.meshMaterial = (int*)MemAlloc(base.meshCount * sizeof(int));
+		model.meshCount = 0;
+		for (int m = 0; m < base.meshCount; ++m) {
+			::Mesh mesh = SimplifyMesh(base.meshes[m], cellsPerAxis);
+			if (mesh.vertexCount == 0) continue;  // Simplified away entirely
+			UploadMesh(&mesh, false);
+			model.meshMaterial[model.meshCount] = base.meshMaterial[m];
+			model.meshes[model.meshCount++] = mesh;
+		}
+
+		generated.push_back(model);
+		levels.push_back({ &generated.back(), screenSize, Triangles(model) });
+		return *this;
+	}
+
+	int LODGroup::Select(int current, float screenSize) const {
+		int level = std::clamp(current, 0, (int)levels.size() - 1);
+		// Coarser while clearly below the next level's switch size, finer while clearly above this level's
+		while (level + 1 < (int)levels.size() && screenSize < levels[level + 1].maxScreenSize * (1 - hysteresis))
+			level++;
+		while (level > 0 && screenSize > levels[level].maxScreenSize * (1 + hysteresis))
+			level--;
+		return level;
+	}
+
+	size_t LODGroup::Triangles(const ::Model& model) {
+		size_t triangles = 0;
+		for (int m = 0; m < model.meshCount; ++m) triangles += model.meshes[m].triangleCount;
+		return triangles;
+	}
+}
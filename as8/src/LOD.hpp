@@ -0,0 +1,55 @@
+#ifndef LOD_HPP
+#define LOD_HPP
+
+#include "raylib-cpp.hpp"
+#include <deque>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace cs381 {
+
+	// Simplified copy of a mesh by vertex clustering: vertices are snapped to a grid with cellsPerAxis cells along the
+	// mesh's longest side, vertices sharing a cell (and a texture color) merge and collapsed triangles are dropped
+	// Only fills the CPU arrays (allocated with MemAlloc so UnloadMesh frees them), UploadMesh before drawing
+	// Returns an empty mesh (vertexCount 0) when the result wouldn't fit 16 bit indices
+	::Mesh SimplifyMesh(const ::Mesh& mesh, int cellsPerAxis);
+
+	// The detail levels of one model, level 0 is the original model
+	// Coarser levels are either loaded from files the user supplies or generated at load with SimplifyMesh, generated
+	// levels share the original's materials and only own their meshes
+	struct LODGroup {
+		struct Level {
+			const ::Model* model;
+			float maxScreenSize;  // Used once the model covers less than this fraction of the screen's height (and no coarser level applies)
+			size_t triangles;  // Sum over the level's meshes
+		};
+
+		std::vector<Level> levels;
+		float hysteresis = 0.15f;  // A level boundary must be passed by this fraction before switching, so models don't flicker between levels
+
+		LODGroup(const ::Model& base) { levels.push_back({ &base, std::numeric_limits<float>::infinity(), Triangles(base) }); }
+		LODGroup(const LODGroup&) = delete;
+		~LODGroup();
+
+		// Adds a coarser level used below screenSize (smaller than the previous level's): loaded from path when that file
+		// exists, otherwise the original is simplified with cellsPerAxis clusters (see SimplifyMesh)
+		LODGroup& AddLevel(float screenSize, const std::string& path, int cellsPerAxis);
+
+		const ::Model& Model(int level) const { return *levels[level].model; }
+		int Select(int current, float screenSize) const;  // The level to use next, given the one in use now
+
+		static size_t Triangles(const ::Model& model);
+
+	protected:
+		std::deque<raylib::Model> loaded;  // Levels loaded from files (deques, so levels can point into them)
+		std::deque<::Model> generated;  // Levels built by SimplifyMesh
+	};
+
+	// Fraction of the screen's height covered by a sphere of radius at distance, for a perspective camera of fovy degrees
+	inline float ScreenSize(float radius, float distance, float fovy) {
+		return distance > radius ? radius / (distance * tanf(fovy * DEG2RAD * 0.5f)) : 1;
+	}
+}
+
+#endif // LOD_HPP
@@ -0,0 +1,153 @@
+#include "OcclusionBuffer.hpp"
+#include <raymath.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace cs381 {
+
+	// Four pixels per register, with the compiler's vector extensions (SSE2 on x86-64, NEON on ARM, plain loops elsewhere)
+	typedef float Float4 __attribute__((vector_size(4 * sizeof(float))));
+	typedef int32_t Int4 __attribute__((vector_size(4 * sizeof(int32_t))));
+
+	constexpr float nearW = 0.01f;  // raylib's default near plane, vertices closer than this can't be projected safely
+
+	static Float4 Broadcast(float f) { return Float4{} + f; }
+	static Float4 Select(Int4 mask, Float4 a, Float4 b) { return (Float4)((mask & (Int4)a) | (~mask & (Int4)b)); }
+
+	static Vector4 ToClip(Vector3 v, const ::Matrix& m) {
+		return {
+			m.m0 * v.x + m.m4 * v.y + m.m8 * v.z + m.m12,
+			m.m1 * v.x + m.m5 * v.y + m.m9 * v.z + m.m13,
+			m.m2 * v.x + m.m6 * v.y + m.m10 * v.z + m.m14,
+			m.m3 * v.x + m.m7 * v.y + m.m11 * v.z + m.m15
+		};
+	}
+
+	OcclusionBuffer::OcclusionBuffer(int width, int height)
+		: width((width + 3) & ~3), height(height), depth(this->width * height, 0), viewProjection(MatrixIdentity()) {
+		bands.resize((height + bandRows - 1) / bandRows);
+		for (size_t band = 0; band < bands.size(); ++band)
+			bandTasks.push_back([this, band] { RasterizeBand(band); });
+	}
+
+	void OcclusionBuffer::AddOccluder(const ::Mesh& mesh, const ::Matrix& transform) {
+		if (!mesh.vertices) return;
+		for (int t = 0; t < mesh.triangleCount; ++t)
+			for (int corner = 0; corner < 3; ++corner) {
+				int v = mesh.indices ? mesh.indices[t * 3 + corner] : t * 3 + corner;
+				occluders.push_back(Vector3Transform({ mesh.vertices[v * 3], mesh.vertices[v * 3 + 1], mesh.vertices[v * 3 + 2] }, transform));
+			}
+	}
+
+	void OcclusionBuffer::Rasterize(const ::Matrix& viewProjection, FrameWorkerPool* pool) {
+		this->viewProjection = viewProjection;
+		stats = {};
+		std::fill(depth.begin(), depth.end(), 0.0f);
+		triangles.clear();
+		for (auto& band : bands) band.clear();
+
+		// Project and set up every triangle, then sort them into the bands they touch
+		for (size_t i = 0; i + 2 < occluders.size(); i += 3) {
+			float x[3], y[3], inverseW[3];
+			bool behind = false;
+			for (int corner = 0; corner < 3; ++corner) {
+				Vector4 clip = ToClip(occluders[i + corner], viewProjection);
+				if (clip.w < nearW) behind = true;
+				inverseW[corner] = 1 / clip.w;
+				x[corner] = (clip.x * inverseW[corner] * 0.5f + 0.5f) * width;
+				y[corner] = (0.5f - clip.y * inverseW[corner] * 0.5f) * height;
+			}
+			if (behind) continue;  // Clipping it would be exact, skipping it is just less occlusion
+
+			float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+			if (fabsf(area) < 1e-6f) continue;
+			float sign = area > 0 ? 1 : -1;  // Both windings are drawn, flip the edges so inside is always positive
+
+			Triangle triangle;
+			for (int edge = 0; edge < 3; ++edge) {  // Edge opposite corner `edge`, its value is that corner's barycentric weight times |area|
+				int a = (edge + 1) % 3, b = (edge + 2) % 3;
+				triangle.edgeX[edge] = -(y[b] - y[a]) * sign;
+				triangle.edgeY[edge] = (x[b] - x[a]) * sign;
+				triangle.edgeC[edge] = ((y[b] - y[a]) * x[a] - (x[b] - x[a]) * y[a]) * sign;
+			}
+			float inverseArea = 1 / fabsf(area);
+			triangle.depthX = triangle.depthY = triangle.depthC = 0;
+			for (int corner = 0; corner < 3; ++corner) {
+				triangle.depthX += triangle.edgeX[corner] * inverseW[corner] * inverseArea;
+				triangle.depthY += triangle.edgeY[corner] * inverseW[corner] * inverseArea;
+				triangle.depthC += triangle.edgeC[corner] * inverseW[corner] * inverseArea;
+			}
+
+			triangle.minX = std::max(0, (int)floorf(std::min({ x[0], x[1], x[2] })));
+			triangle.maxX = std::min(width - 1, (int)floorf(std::max({ x[0], x[1], x[2] })));
+			triangle.minY = std::max(0, (int)floorf(std::min({ y[0], y[1], y[2] })));
+			triangle.maxY = std::min(height - 1, (int)floorf(std::max({ y[0], y[1], y[2] })));
+			if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) continue;  // Off screen
+
+			uint32_t index = triangles.size();
+			triangles.push_back(triangle);
+			for (int band = triangle.minY / bandRows; band <= triangle.maxY / bandRows; ++band)
+				bands[band].push_back(index);
+		}
+		stats.triangles = triangles.size();
+
+		if (pool) pool->Run(bandTasks);
+		else for (auto& task : bandTasks) task();
+	}
+
+	void OcclusionBuffer::RasterizeBand(size_t band) {
+		int bandStart = band * bandRows, bandEnd = std::min(height, bandStart + bandRows) - 1;
+		const Float4 laneOffsets = { 0.5f, 1.5f, 2.5f, 3.5f };  // Pixel centers
+		for (uint32_t index : bands[band]) {
+			const Triangle& t = triangles[index];
+			int rowStart = std::max(bandStart, t.minY), rowEnd = std::min(bandEnd, t.maxY);
+			int columnStart = t.minX & ~3;  // Whole registers, width is a multiple of 4
+			for (int y = rowStart; y <= rowEnd; ++y) {
+				float centerY = y + 0.5f;
+				Float4 edgeRow0 = Broadcast(t.edgeY[0] * centerY + t.edgeC[0]);
+				Float4 edgeRow1 = Broadcast(t.edgeY[1] * centerY + t.edgeC[1]);
+				Float4 edgeRow2 = Broadcast(t.edgeY[2] * centerY + t.edgeC[2]);
+				Float4 depthRow = Broadcast(t.depthY * centerY + t.depthC);
+				float* row = depth.data() + y * width;
+				for (int x = columnStart; x <= t.maxX; x += 4) {
+					Float4 centerX = Broadcast((float)x) + laneOffsets;
+					Int4 inside = (t.edgeX[0] * centerX + edgeRow0 >= 0) & (t.edgeX[1] * centerX + edgeRow1 >= 0) & (t.edgeX[2] * centerX + edgeRow2 >= 0);
+					Float4 z = t.depthX * centerX + depthRow;
+					Float4 current;
+					std::memcpy(&current, row + x, sizeof(current));
+					current = Select(inside & (z > current), z, current);  // Keep the nearest occluder
+					std::memcpy(row + x, &current, sizeof(current));
+				}
+			}
+		}
+	}
+
+	bool OcclusionBuffer::Visible(const BoundingBox& box) {
+		stats.tested++;
+		float minX = INFINITY, maxX = -INFINITY, minY = INFINITY, maxY = -INFINITY, nearest = 0;
+		for (int i = 0; i < 8; ++i) {
+			Vector3 corner = { i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z };
+			Vector4 clip = ToClip(corner, viewProjection);
+			if (clip.w < nearW) return true;  // Reaches past the camera, nothing can be in front of all of it
+			float inverseW = 1 / clip.w;
+			float x = (clip.x * inverseW * 0.5f + 0.5f) * width, y = (0.5f - clip.y * inverseW * 0.5f) * height;
+			minX = std::min(minX, x); maxX = std::max(maxX, x);
+			minY = std::min(minY, y); maxY = std::max(maxY, y);
+			nearest = std::max(nearest, inverseW);
+		}
+
+		// Every pixel the rectangle touches must hold an occluder nearer than the box's nearest point
+		int x0 = std::max(0, (int)floorf(minX)), x1 = std::min(width - 1, (int)floorf(maxX));
+		int y0 = std::max(0, (int)floorf(minY)), y1 = std::min(height - 1, (int)floorf(maxY));
+		if (x0 > x1 || y0 > y1) return true;  // Off screen, that is for frustum culling to decide
+		for (int y = y0; y <= y1; ++y) {
+			const float* row = depth.data() + y * width;
+			for (int x = x0; x <= x1; ++x)
+				if (row[x] <= nearest) return true;
+		}
+		stats.occluded++;
+		return false;
+	}
+}
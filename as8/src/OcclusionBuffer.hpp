@@ -0,0 +1,68 @@
+#ifndef OCCLUSION_BUFFER_HPP
+#define OCCLUSION_BUFFER_HPP
+
+#include <raylib.h>
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "FrameWorkerPool.hpp"
+
+namespace cs381 {
+
+	// Software occlusion culling: a small depth buffer drawn on the CPU from a few large occluders (walls, corridors...),
+	// which bounding boxes are then tested against before anything is submitted to the GPU
+	// Depth is stored as 1/w (the reciprocal of view depth, which interpolates linearly across a triangle), bigger is
+	// nearer and 0 means nothing was drawn. Rows are split into bands which are rasterized in parallel, 4 pixels at a time
+	// Everything is plain math on raylib's structs: no GL calls or queries, so it runs without a window or GPU
+	// Approximations err towards visible (occluder triangles crossing the near plane are skipped, boxes are tested with
+	// their nearest depth over their whole screen rectangle) except at occluder outlines: an occluder covers every pixel
+	// whose center it contains, so up to half a pixel of a box peeking past an outline can still be culled. Coverage is
+	// not made conservative because per triangle it would leave uncovered cracks along every edge shared inside a mesh
+	struct OcclusionBuffer {
+		constexpr static int bandRows = 16;  // Rows per band, one task per band
+
+		struct Stats {
+			size_t triangles = 0;  // Occluder triangles drawn by the last Rasterize
+			size_t tested = 0;  // Visible calls since that Rasterize
+			size_t occluded = 0;  // Of those, how many returned false
+		};
+
+		Stats stats;
+
+		OcclusionBuffer(int width = 256, int height = 128);
+
+		int Width() const { return width; }
+		int Height() const { return height; }
+		std::span<const float> Depth() const { return depth; }  // Row major, row 0 at the top
+
+		void AddOccluder(const ::Mesh& mesh, const ::Matrix& transform);  // Kept (in world space) until ClearOccluders
+		void ClearOccluders() { occluders.clear(); }
+		size_t OccluderTriangles() const { return occluders.size() / 3; }
+
+		// Redraws the depth buffer from the occluders, for viewProjection (MatrixMultiply(view, projection))
+		// With a pool the bands are spread over its workers, otherwise they are drawn on the calling thread
+		void Rasterize(const ::Matrix& viewProjection, FrameWorkerPool* pool = nullptr);
+
+		bool Visible(const BoundingBox& box);  // False only when the box is entirely behind drawn occluders
+
+	protected:
+		// Edge functions and depth as planes over the screen, evaluated at pixel centers
+		struct Triangle {
+			float edgeX[3], edgeY[3], edgeC[3];  // edge(x, y) = edgeX * x + edgeY * y + edgeC, all three >= 0 inside
+			float depthX, depthY, depthC;  // 1/w at (x, y)
+			int minX, maxX, minY, maxY;  // Pixels the triangle's bounding rectangle touches, clamped to the screen
+		};
+
+		int width, height;
+		std::vector<float> depth;
+		::Matrix viewProjection;
+		std::vector<Vector3> occluders;  // World space, three per triangle
+		std::vector<Triangle> triangles;  // This frame's, set up for rasterizing
+		std::vector<std::vector<uint32_t>> bands;  // Triangles touching each band
+		std::vector<FrameWorkerPool::Task> bandTasks;
+
+		void RasterizeBand(size_t band);
+	};
+}
+
+#endif // OCCLUSION_BUFFER_HPP
@@ -0,0 +1,44 @@
+#include "RenderQueue.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace cs381 {
+
+	uint64_t RenderQueue::Key(Pass pass, unsigned shader, unsigned texture, float depth) {
+		// Non negative floats sort the same as their bit patterns, so depth can be compared as an integer
+		uint32_t depthBits = std::bit_cast<uint32_t>(std::max(depth, 0.0f));
+		return (uint64_t)(pass & 0xF) << 60 | (uint64_t)(shader & 0xFFF) << 48 | (uint64_t)(texture & 0xFFFF) << 32 | depthBits;
+	}
+
+	void RenderQueue::Add(Pass pass, const ::Mesh& mesh, const ::Material& material, std::span<const ::Matrix> transforms, float depth, bool instanced) {
+		if (transforms.empty()) return;
+		order.push_back({ Key(pass, material.shader.id, material.maps[MATERIAL_MAP_DIFFUSE].texture.id, depth), (uint32_t)items.size() });
+		items.push_back({ &mesh, material, transforms, instanced, {} });
+	}
+
+	void RenderQueue::Add(uint64_t key, std::function<void()> draw) {
+		order.push_back({ key, (uint32_t)items.size() });
+		items.push_back({ nullptr, {}, {}, false, std::move(draw) });
+	}
+
+	RenderQueue& RenderQueue::Submit() {
+		std::sort(order.begin(), order.end());
+
+		stats = { order.size(), 0 };
+		uint64_t previousState = ~0ull;
+		for (auto [key, index] : order) {
+			uint64_t state = key >> 32;  // Pass, shader and texture
+			if (state != previousState) stats.stateChanges++;
+			previousState = state;
+
+			Item& item = items[index];
+			if (item.draw) item.draw();
+			else if (item.transforms.size() == 1 && !item.instanced) DrawMesh(*item.mesh, item.material, item.transforms[0]);
+			else DrawMeshInstanced(*item.mesh, item.material, item.transforms.data(), item.transforms.size());
+		}
+
+		items.clear();
+		order.clear();
+		return *this;
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include <raylib.h>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace cs381 {
+
+	// Draws are collected for the whole frame, then sorted by a 64 bit key and submitted in that order
+	// Key layout, most significant first: pass (4 bits) | shader id (12) | diffuse texture id (16) | depth (32)
+	// So passes run in order, draws sharing a shader and texture end up next to each other, and within those opaque
+	// geometry goes front to back (the depth test then rejects hidden fragments before they are shaded)
+	struct RenderQueue {
+		enum Pass : uint8_t {
+			Opaque = 0,
+			Sky = 14,  // After all geometry: the sky sits on the far plane and raylib's LEQUAL depth test only lets it through where nothing was drawn
+		};
+
+		struct Stats {
+			size_t items = 0;
+			size_t stateChanges = 0;  // Times the shader or texture differed from the previous draw
+		};
+
+		Stats stats;  // Of the last Submit
+
+		static uint64_t Key(Pass pass, unsigned shader, unsigned texture, float depth);
+
+		// Draws mesh once per transform, with DrawMeshInstanced when there is more than one (material.shader must then support instancing)
+		// or always when instanced is set (for shaders which only read the per instance matrix)
+		// The transforms are not copied, they must stay valid until Submit
+		void Add(Pass pass, const ::Mesh& mesh, const ::Material& material, std::span<const ::Matrix> transforms, float depth, bool instanced = false);
+		void Add(uint64_t key, std::function<void()> draw);  // Anything else (e.g. the sky), drawn when its key comes up
+
+		RenderQueue& Submit();  // Sorts, draws and empties the queue, call inside BeginMode3D
+
+	protected:
+		struct Item {
+			const ::Mesh* mesh;
+			::Material material;
+			std::span<const ::Matrix> transforms;
+			bool instanced;
+			std::function<void()> draw;  // Set instead of mesh for custom items
+		};
+
+		std::vector<Item> items;
+		std::vector<std::pair<uint64_t, uint32_t>> order;  // (key, item) pairs, sorting these is cheaper than sorting items
+	};
+}
+
+#endif // RENDER_QUEUE_HPP
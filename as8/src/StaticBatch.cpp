@@ -0,0 +1,153 @@
+#include "StaticBatch.hpp"
+#include <raymath.h>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <tuple>
+#include <utility>
+
+namespace cs381 {
+
+	constexpr size_t maxChunkVertices = 65536;  // Every index must fit in an unsigned short
+
+	// Vertex data of one chunk while pieces are being merged into it
+	struct ChunkBuilder {
+		const ::Material* material;  // The first source material, for its shader and textures
+		std::vector<float> vertices, normals, texcoords;
+		std::vector<unsigned char> colors;
+		std::vector<unsigned short> indices;
+		BoundingBox bounds = { { INFINITY, INFINITY, INFINITY }, { -INFINITY, -INFINITY, -INFINITY } };
+
+		size_t VertexCount() const { return vertices.size() / 3; }
+	};
+
+	template<typename T>
+	static T* Copy(const std::vector<T>& data) {
+		T* out = (T*)MemAlloc(data.size() * sizeof(T));
+		std::memcpy(out, data.data(), data.size() * sizeof(T));
+		return out;
+	}
+
+	StaticBatch::~StaticBatch() {
+		for (auto& chunk : chunks) {
+			UnloadMesh(chunk.mesh);
+			MemFree(chunk.material.maps);  // UnloadMaterial would also unload the shader and textures, which belong to the source models
+		}
+	}
+
+	void StaticBatch::Add(const ::Model& model, const ::Matrix& transform) {
+		pieces.push_back({ &model, transform });
+		stats.pieces++;
+	}
+
+	StaticBatch& StaticBatch::Build() {
+		// Cell x, cell z, shader, diffuse texture. Ordered, so the same level always bakes into the same chunks
+		std::map<std::tuple<int, int, unsigned, unsigned>, std::vector<ChunkBuilder>> groups;
+		ModelBoundsCache modelBounds;
+		for (auto& piece : pieces) {
+			const ::Model& model = *piece.model;
+			BoundingBox world = TransformBounds(modelBounds.Get(model).box, piece.transform);
+			int cellX = (int)floorf((world.min.x + world.max.x) * 0.5f / cellSize);
+			int cellZ = (int)floorf((world.min.z + world.max.z) * 0.5f / cellSize);
+			::Matrix normalMatrix = MatrixTranspose(MatrixInvert(piece.transform));
+			bool mirrored = MatrixDeterminant(piece.transform) < 0;  // Reverses the winding, the triangles are flipped back below
+
+			for (int m = 0; m < model.meshCount; ++m) {
+				const ::Mesh& mesh = model.meshes[m];
+				const ::Material& material = model.materials[model.meshMaterial[m]];
+				const MaterialMap& diffuse = material.maps[MATERIAL_MAP_DIFFUSE];
+				if ((size_t)mesh.vertexCount > maxChunkVertices) {
+					TraceLog(LOG_WARNING, "STATIC: Skipped a mesh with %d vertices, more than 16 bit indices can address", mesh.vertexCount);
+					continue;
+				}
+
+				auto& group = groups[{ cellX, cellZ, material.shader.id, diffuse.texture.id }];
+				if (group.empty() || group.back().VertexCount() + mesh.vertexCount > maxChunkVertices)
+					group.push_back({ &material });
+				ChunkBuilder& chunk = group.back();
+
+				size_t base = chunk.VertexCount();
+				for (int v = 0; v < mesh.vertexCount; ++v) {
+					Vector3 position = Vector3Transform({ mesh.vertices[v * 3], mesh.vertices[v * 3 + 1], mesh.vertices[v * 3 + 2] }, piece.transform);
+					chunk.vertices.insert(chunk.vertices.end(), { position.x, position.y, position.z });
+					chunk.bounds.min = Vector3Min(chunk.bounds.min, position);
+					chunk.bounds.max = Vector3Max(chunk.bounds.max, position);
+
+					Vector3 normal = { 0, 1, 0 };
+					if (mesh.normals) {
+						const float* n = mesh.normals + v * 3;
+						normal = Vector3Normalize({
+							normalMatrix.m0 * n[0] + normalMatrix.m4 * n[1] + normalMatrix.m8 * n[2],
+							normalMatrix.m1 * n[0] + normalMatrix.m5 * n[1] + normalMatrix.m9 * n[2],
+							normalMatrix.m2 * n[0] + normalMatrix.m6 * n[1] + normalMatrix.m10 * n[2]
+						});
+					}
+					chunk.normals.insert(chunk.normals.end(), { normal.x, normal.y, normal.z });
+
+					if (mesh.texcoords) chunk.texcoords.insert(chunk.texcoords.end(), { mesh.texcoords[v * 2], mesh.texcoords[v * 2 + 1] });
+					else chunk.texcoords.insert(chunk.texcoords.end(), { 0.0f, 0.0f });
+
+					// The material color moves into the vertices, so the merged mesh can be drawn with a white material
+					const unsigned char* c = mesh.colors ? mesh.colors + v * 4 : nullptr;
+					chunk.colors.insert(chunk.colors.end(), {
+						(unsigned char)((c ? c[0] : 255) * diffuse.color.r / 255),
+						(unsigned char)((c ? c[1] : 255) * diffuse.color.g / 255),
+						(unsigned char)((c ? c[2] : 255) * diffuse.color.b / 255),
+						(unsigned char)((c ? c[3] : 255) * diffuse.color.a / 255)
+					});
+				}
+
+				for (int t = 0; t < mesh.triangleCount; ++t) {
+					int a = mesh.indices ? mesh.indices[t * 3] : t * 3;
+					int b = mesh.indices ? mesh.indices[t * 3 + 1] : t * 3 + 1;
+					int c = mesh.indices ? mesh.indices[t * 3 + 2] : t * 3 + 2;
+					if (mirrored) std::swap(b, c);
+					chunk.indices.insert(chunk.indices.end(), { (unsigned short)(base + a), (unsigned short)(base + b), (unsigned short)(base + c) });
+				}
+			}
+		}
+
+		for (auto& [key, group] : groups)
+			for (auto& builder : group) {
+				if (builder.indices.empty()) continue;
+				Chunk chunk = { {}, LoadMaterialDefault(), builder.bounds };
+				chunk.mesh.vertexCount = builder.VertexCount();
+				chunk.mesh.triangleCount = builder.indices.size() / 3;
+				chunk.mesh.vertices = Copy(builder.vertices);
+				chunk.mesh.normals = Copy(builder.normals);
+				chunk.mesh.texcoords = Copy(builder.texcoords);
+				chunk.mesh.colors = Copy(builder.colors);
+				chunk.mesh.indices = Copy(builder.indices);
+				UploadMesh(&chunk.mesh, false);
+
+				chunk.material.shader = builder.material->shader;
+				chunk.material.maps[MATERIAL_MAP_DIFFUSE].texture = builder.material->maps[MATERIAL_MAP_DIFFUSE].texture;
+				chunks.push_back(chunk);
+			}
+
+		std::vector<uint32_t> ids(chunks.size());
+		std::vector<BoundingBox> boxes(chunks.size());
+		for (uint32_t i = 0; i < chunks.size(); ++i) {
+			ids[i] = i;
+			boxes[i] = chunks[i].bounds;
+		}
+		tree.Build(ids, boxes);
+
+		stats.meshes = chunks.size();
+		pieces.clear();
+		return *this;
+	}
+
+	void StaticBatch::Enqueue(RenderQueue& queue, const Frustum& frustum, Vector3 eye) {
+		static const ::Matrix identity = MatrixIdentity();  // Merged vertices are already in world space
+		visible.clear();
+		tree.Visible(frustum, visible);
+		stats.drawn = visible.size();
+		for (uint32_t i : visible) {
+			const Chunk& chunk = chunks[i];
+			// Chunks are large, so they are sorted by their closest point rather than their center
+			float depth = Vector3DistanceSqr(eye, Vector3Clamp(eye, chunk.bounds.min, chunk.bounds.max));
+			queue.Add(RenderQueue::Opaque, chunk.mesh, chunk.material, { &identity, 1 }, depth);
+		}
+	}
+}
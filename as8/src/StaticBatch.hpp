@@ -0,0 +1,59 @@
+#ifndef STATIC_BATCH_HPP
+#define STATIC_BATCH_HPP
+
+#include <raylib.h>
+#include <cstddef>
+#include <vector>
+#include "Bounds.hpp"
+#include "BVH.hpp"
+#include "RenderQueue.hpp"
+
+namespace cs381 {
+
+	// Level pieces which never move (Space Kit corridors, platforms, terrain...) baked into a few large meshes
+	// Pieces are added with their world matrix, Build then sorts them into square cells on the XZ plane (by the center
+	// of their bounds) and, per cell, merges every mesh sharing a shader and diffuse texture into one world space mesh
+	// Material colors are multiplied into the vertex colors while merging, so pieces which only differ in color (all of
+	// the Space Kit) end up in the same mesh. Each merged mesh keeps its own bounds and is frustum culled as a whole
+	// A cell is split into more meshes when it passes the 65535 vertices raylib's 16 bit indices can address
+	// The merged meshes never move, so they get a BVH built once (with SAH) for the frustum test
+	struct StaticBatch {
+		struct Stats {
+			size_t pieces = 0;  // Added before Build
+			size_t meshes = 0;  // Merged meshes Build produced
+			size_t drawn = 0;  // Merged meshes the last Enqueue didn't cull
+		};
+
+		float cellSize;
+		Stats stats;
+
+		StaticBatch(float cellSize = 32) : cellSize(cellSize) {}
+		StaticBatch(const StaticBatch&) = delete;
+		~StaticBatch();
+
+		// model must stay loaded until Build, its materials' shaders and textures until the batch is destroyed
+		void Add(const ::Model& model, const ::Matrix& transform);
+		StaticBatch& Build();  // Merges and uploads everything added so far, needs the window to exist
+
+		void Enqueue(RenderQueue& queue, const Frustum& frustum, Vector3 eye);  // Adds the visible merged meshes as opaque draws
+
+	protected:
+		struct Piece {
+			const ::Model* model;
+			::Matrix transform;
+		};
+
+		struct Chunk {
+			::Mesh mesh;
+			::Material material;  // Own maps, sharing the source material's shader and textures
+			BoundingBox bounds;  // World space
+		};
+
+		std::vector<Piece> pieces;  // Waiting for Build
+		std::vector<Chunk> chunks;
+		BVH tree;  // Over chunks, ids are indices into chunks
+		std::vector<uint32_t> visible;
+	};
+}
+
+#endif // STATIC_BATCH_HPP
@@ -1,19 +1,34 @@
 #include <raylib-cpp.hpp>
+#include <algorithm>
+#include <functional>
+#include <span>
 #include <vector>
+#include <memory>
+#include <string>
 #include <cmath>
+#include <cstdlib>
 #include "skybox.hpp"
 #include "ECS.hpp"
+#include "BatchMath.hpp"
+#include "Bounds.hpp"
+#include "BVH.hpp"
+#include "DebugDraw.hpp"
+#include "FixedTimestep.hpp"
+#include "FrameWorkerPool.hpp"
+#include "Impostor.hpp"
+#include "InstancedRenderer.hpp"
+#include "LOD.hpp"
+#include "OcclusionBuffer.hpp"
+#include "RenderQueue.hpp"
+#include "StaticBatch.hpp"
 
 constexpr int SCREEN_WIDTH = 800;
 constexpr int SCREEN_HEIGHT = 600;
-constexpr int MAX_ENTITIES = 100;
 
-using EntityID = size_t;
+size_t globalComponentCounter = 0;
 
-inline EntityID CreateEntity() {
-    static EntityID next = 0;
-    return next++;
-}
+using EntityID = cs381::Entity;
+constexpr EntityID NO_ENTITY = UINT32_MAX;  // Same as an empty BVH hit
 
 struct TransformComponent {
     Vector3 position;
@@ -44,145 +59,397 @@ struct Physics3DComponent {
     Vector3 angular;
 };
 
-std::vector<TransformComponent> transformPool(MAX_ENTITIES);
-std::vector<RenderComponent> renderPool(MAX_ENTITIES);
-std::vector<VelocityComponent> velocityPool(MAX_ENTITIES);
-std::vector<Physics2DComponent> physics2DPool(MAX_ENTITIES);
-std::vector<Physics3DComponent> physics3DPool(MAX_ENTITIES);
-std::vector<bool> hasTransform(MAX_ENTITIES, false);
-std::vector<bool> hasRender(MAX_ENTITIES, false);
-std::vector<bool> hasVelocity(MAX_ENTITIES, false);
-std::vector<bool> hasPhysics2D(MAX_ENTITIES, false);
-std::vector<bool> hasPhysics3D(MAX_ENTITIES, false);
-std::vector<bool> selectionPool(MAX_ENTITIES, false);
+// Which detail level of the entity's model is drawn, picked by LODSystem (see LOD.hpp)
+struct LODComponent {
+    cs381::LODGroup* group;
+    int level;
+};
+
+// Where the entity was before the last simulation tick, drawing blends from it to the current transform
+struct PreviousTransformComponent {
+    Vector3 position;
+    Quaternion rotation;
+};
+
+// Drawn instead of the model past impostorDistance (see Impostor.hpp)
+struct ImpostorComponent {
+    cs381::ImpostorAtlas* atlas;
+};
+
+// Every entity and its components, systems walk views of the components they need (see ECS.hpp)
+cs381::Scene<> world;
 
 raylib::Model carModels[5];
 raylib::Model rocketModel;
+raylib::Model terrainModel, roadModel, corridorModel, corridorEndModel, corridorWindowModel, platformModel;
 raylib::Texture skyTex;
 cs381::SkyBox* skybox;
 
 raylib::Camera3D camera;
+cs381::ModelBoundsCache modelBounds;
+size_t culledEntities = 0;
+size_t occludedEntities = 0;
+bool showAllBounds = false;  // Every drawn entity's bounds and axes, not just the selection's
+constexpr int MAX_LOD_LEVELS = 4;
+size_t lodEntities[MAX_LOD_LEVELS], lodTriangles[MAX_LOD_LEVELS];  // Drawn per level last frame
+constexpr float IMPOSTOR_DISTANCES[] = { 150, 40, INFINITY };  // Cycled with P, INFINITY turns impostors off
+int impostorSetting = 0;
+size_t impostorEntities = 0;
 std::vector<EntityID> entityOrder;
 int selectedIndex = 0;
 
 EntityID CreateCar(Vector3 pos, float maxSpeed, float accel, float turnRate, raylib::Model& model) {
-    EntityID e = CreateEntity();
-    transformPool[e] = { pos, {0, 0, 0}, {1, 1, 1} };
-    renderPool[e] = { &model, true };
-    velocityPool[e] = { {0, 0, 0}, 0.0f, 0.0f, maxSpeed, accel };
-    physics2DPool[e] = { 0.0f, turnRate };
-    hasTransform[e] = hasRender[e] = hasVelocity[e] = hasPhysics2D[e] = true;
+    EntityID e = world.CreateEntity();
+    world.AddComponent<TransformComponent>(e) = { pos, {0, 0, 0}, {1, 1, 1} };
+    world.AddComponent<RenderComponent>(e) = { &model, true };
+    world.AddComponent<VelocityComponent>(e) = { {0, 0, 0}, 0.0f, 0.0f, maxSpeed, accel };
+    world.AddComponent<Physics2DComponent>(e) = { 0.0f, turnRate };
+    world.AddComponent<PreviousTransformComponent>(e) = { pos, QuaternionIdentity() };
     entityOrder.push_back(e);
     return e;
 }
 
+// A Space Kit base behind the vehicles. None of it ever moves, so it is baked into a StaticBatch (see StaticBatch.hpp)
+struct BasePiece {
+    raylib::Model* model;
+    Matrix transform;
+    bool occluder;  // Big and solid enough to hide what is behind it (see OcclusionBuffer.hpp)
+};
+std::vector<BasePiece> basePieces;  // Also drawn one by one when static batching is turned off
+
+void LayoutBase() {
+    const char* kit = "../assets/Kenny Space Kit/";
+    terrainModel = raylib::Model(std::string(kit) + "terrain.glb");
+    roadModel = raylib::Model(std::string(kit) + "terrain_roadStraight.glb");
+    corridorModel = raylib::Model(std::string(kit) + "corridor.glb");
+    corridorEndModel = raylib::Model(std::string(kit) + "corridor_end.glb");
+    corridorWindowModel = raylib::Model(std::string(kit) + "corridor_window.glb");
+    platformModel = raylib::Model(std::string(kit) + "platform_large.glb");
+
+    constexpr float tile = 4;  // Kit pieces are 1 unit wide
+    auto place = [](raylib::Model& model, Vector3 position, float yaw, bool occluder = false) {
+        Matrix transform = MatrixMultiply(MatrixMultiply(MatrixScale(tile, tile, tile), MatrixRotateY(yaw * DEG2RAD)), MatrixTranslate(position.x, position.y, position.z));
+        basePieces.push_back({ &model, transform, occluder });
+    };
+
+    // Ground, 24 x 10 tiles with a road across it, just above the grass so the two don't fight over depth
+    for (int z = 0; z < 10; z++)
+        for (int x = 0; x < 24; x++)
+            place(z == 4 ? roadModel : terrainModel, { -46 + x * tile, 0.01f, -10 - z * tile }, z == 4 ? 90 : 0);
+
+    // A corridor running away from the camera, capped at both ends
+    place(corridorEndModel, { 30, 0.01f, -14 }, 0, true);
+    for (int z = 1; z < 8; z++)
+        place(z % 3 ? corridorModel : corridorWindowModel, { 30, 0.01f, -14 - z * tile }, 0, true);
+    place(corridorEndModel, { 30, 0.01f, -14 - 8 * tile }, 180, true);
+
+    // Landing pads
+    for (int z = 0; z < 2; z++)
+        for (int x = 0; x < 3; x++)
+            place(platformModel, { -34 + x * 2 * tile, 0.01f, -18 - z * 2 * tile }, 0);
+}
+
 EntityID CreateRocket(Vector3 pos, raylib::Model& model) {
-    EntityID e = CreateEntity();
-    transformPool[e] = { pos, {0, 0, 0}, {1, 1, 1} };
-    renderPool[e] = { &model, true };
-    velocityPool[e] = { {0, 0, 0}, 0.0f, 0.0f, 20.0f, 8.0f };
-    physics3DPool[e] = { QuaternionIdentity(), {0, 0, 0} };
-    hasTransform[e] = hasRender[e] = hasVelocity[e] = hasPhysics3D[e] = true;
+    EntityID e = world.CreateEntity();
+    world.AddComponent<TransformComponent>(e) = { pos, {0, 0, 0}, {1, 1, 1} };
+    world.AddComponent<RenderComponent>(e) = { &model, true };
+    world.AddComponent<VelocityComponent>(e) = { {0, 0, 0}, 0.0f, 0.0f, 20.0f, 8.0f };
+    world.AddComponent<Physics3DComponent>(e) = { QuaternionIdentity(), {0, 0, 0} };
+    world.AddComponent<PreviousTransformComponent>(e) = { pos, QuaternionIdentity() };
     entityOrder.push_back(e);
     return e;
 }
 
 void KinematicsSystem(float dt) {
-    for (EntityID e = 0; e < MAX_ENTITIES; ++e) {
-        if (hasTransform[e] && hasVelocity[e]) {
-            transformPool[e].position = Vector3Add(transformPool[e].position, Vector3Scale(velocityPool[e].velocity, dt));
-        }
-    }
+    world.View<TransformComponent, VelocityComponent>().ForEach([dt](EntityID, TransformComponent& transform, VelocityComponent& vel) {
+        transform.position = Vector3Add(transform.position, Vector3Scale(vel.velocity, dt));
+    });
 }
 
 void Physics2DSystem(float dt) {
-    for (EntityID e = 0; e < MAX_ENTITIES; ++e) {
-        if (hasPhysics2D[e] && hasVelocity[e]) {
-            float headingRad = physics2DPool[e].heading * DEG2RAD;
-            velocityPool[e].velocity = { cosf(headingRad) * velocityPool[e].speed, 0, -sinf(headingRad) * velocityPool[e].speed };
-        }
-    }
+    world.View<Physics2DComponent, VelocityComponent>().ForEach([](EntityID, Physics2DComponent& phys, VelocityComponent& vel) {
+        float headingRad = phys.heading * DEG2RAD;
+        vel.velocity = { cosf(headingRad) * vel.speed, 0, -sinf(headingRad) * vel.speed };
+    });
 }
 
+// Rockets are gathered into SoA arrays so their quaternion math runs in batches (see BatchMath.hpp)
+cs381::batch::QuaternionArray rocketRotations, rocketDeltas;
+cs381::batch::Vector3Array rocketForward, rocketDirections;
+std::vector<EntityID> movingRockets;
+
 void Physics3DSystem(float dt) {
-    for (EntityID e = 0; e < MAX_ENTITIES; ++e) {
-        if (hasPhysics3D[e] && hasVelocity[e]) {
-            auto& phys = physics3DPool[e];
-            auto& vel = velocityPool[e];
-
-            // Apply rotation and movement if velocity is non-zero
-            if (vel.velocity.x != 0.0f || vel.velocity.y != 0.0f || vel.velocity.z != 0.0f) {
-                // Apply rotation based on angular velocity (yaw, pitch, roll)
-                Quaternion deltaRot = QuaternionFromEuler(
-                    phys.angular.x * dt, // Pitch
-                    phys.angular.y * dt, // Yaw
-                    phys.angular.z * dt  // Roll
-                );
-                phys.rotation = QuaternionNormalize(QuaternionMultiply(phys.rotation, deltaRot));
-
-                // Calculate forward direction based on current rotation
-                Vector3 dir = Vector3RotateByQuaternion({1, 0, 0}, phys.rotation); // forward direction
-                dir.y = 0; // ignore Y for rotation-based movement to keep it on a flat plane
-
-                // Forward movement based on the velocity
-                Vector3 forward = Vector3Scale(dir, vel.velocity.y); // Apply velocity along forward direction
-                vel.velocity.x = forward.x; // Update the velocity in the x direction
-                vel.velocity.z = forward.z; // Update the velocity in the z direction
-            }
+    movingRockets.clear();
+    rocketRotations.clear();
+    rocketDeltas.clear();
+    world.View<Physics3DComponent, VelocityComponent>().ForEach([dt](EntityID e, Physics3DComponent& phys, VelocityComponent& vel) {
+        // Apply rotation and movement if velocity is non-zero
+        if (vel.velocity.x != 0.0f || vel.velocity.y != 0.0f || vel.velocity.z != 0.0f) {
+            movingRockets.push_back(e);
+            rocketRotations.push_back(phys.rotation);
+            // Apply rotation based on angular velocity (yaw, pitch, roll)
+            rocketDeltas.push_back(QuaternionFromEuler(
+                phys.angular.x * dt, // Pitch
+                phys.angular.y * dt, // Yaw
+                phys.angular.z * dt  // Roll
+            ));
         }
+    });
+
+    cs381::batch::Multiply(rocketRotations, rocketDeltas, rocketRotations);
+    cs381::batch::Normalize(rocketRotations);
+
+    // Calculate forward direction based on current rotation
+    rocketForward.clear();
+    for (size_t i = 0; i < movingRockets.size(); ++i) rocketForward.push_back({1, 0, 0}); // forward direction
+    cs381::batch::RotateByQuaternion(rocketForward, rocketRotations, rocketDirections);
+
+    for (size_t i = 0; i < movingRockets.size(); ++i) {
+        EntityID e = movingRockets[i];
+        auto& vel = world.GetComponent<VelocityComponent>(e);
+        world.GetComponent<Physics3DComponent>(e).rotation = rocketRotations.Get(i);
+
+        Vector3 dir = rocketDirections.Get(i);
+        dir.y = 0; // ignore Y for rotation-based movement to keep it on a flat plane
+
+        // Forward movement based on the velocity
+        Vector3 forward = Vector3Scale(dir, vel.velocity.y); // Apply velocity along forward direction
+        vel.velocity.x = forward.x; // Update the velocity in the x direction
+        vel.velocity.z = forward.z; // Update the velocity in the z direction
     }
 }
 
 
 
-void RenderSystem() {
-    for (EntityID e = 0; e < MAX_ENTITIES; ++e) {
-        if (hasTransform[e] && hasRender[e]) {
-            // Start with the translation matrix
-            Matrix transform = MatrixTranslate(transformPool[e].position.x, transformPool[e].position.y, transformPool[e].position.z);
-            transform = MatrixMultiply(transform, MatrixScale(transformPool[e].scale.x, transformPool[e].scale.y, transformPool[e].scale.z));
+// Coarser levels are loaded from <model>_lod1.glb, <model>_lod2.glb when they exist, otherwise simplified from the model
+std::unique_ptr<cs381::LODGroup> LoadLODs(const raylib::Model& model, const std::string& path) {
+    std::string stem = path.substr(0, path.rfind('.'));
+    auto group = std::make_unique<cs381::LODGroup>(model);
+    group->AddLevel(0.12f, stem + "_lod1.glb", 12).AddLevel(0.04f, stem + "_lod2.glb", 5);
+    return group;
+}
 
-            if (hasPhysics2D[e]) {
-                // Apply 2D rotation for the car
-                auto& phys = physics2DPool[e];
-                Matrix rotationMatrix = MatrixRotateY(phys.heading * DEG2RAD); // Rotate around Y-axis for car's heading
-                transform = MatrixMultiply(transform, rotationMatrix);  // Apply the rotation to the transformation matrix
-            }
+void AttachLOD(EntityID e, cs381::LODGroup& group) {
+    world.AddComponent<LODComponent>(e) = { &group, 0 };
+}
 
-            if (hasPhysics3D[e]) {
-                // Apply the quaternion rotation for the rocket
-                auto& phys = physics3DPool[e];
-                Matrix rotationMatrix = QuaternionToMatrix(phys.rotation);  // Convert quaternion to matrix
-                transform = MatrixMultiply(transform, rotationMatrix);  // Apply the rotation to the transformation matrix
-            }
+// Atlases are cached as <model>_impostor_<key>.png in the working directory (see ImpostorAtlas), delete them to bake again
+std::unique_ptr<cs381::ImpostorAtlas> LoadImpostor(const raylib::Model& model, const std::string& path) {
+    return std::make_unique<cs381::ImpostorAtlas>(model, modelBounds.Get(model).box, GetFileNameWithoutExt(path.c_str()), 16);
+}
 
-            renderPool[e].model->transform = transform;
-            renderPool[e].model->Draw({});
+void AttachImpostor(EntityID e, cs381::ImpostorAtlas& atlas) {
+    world.AddComponent<ImpostorComponent>(e) = { &atlas };
+}
+
+// Picks each entity's detail level from how much of the screen its bounding sphere covers
+void LODSystem() {
+    world.View<TransformComponent, LODComponent>().ForEach([](EntityID, TransformComponent& transform, LODComponent& lod) {
+        Vector3 scale = transform.scale;
+        float radius = modelBounds.Get(lod.group->Model(0)).radius * std::max({ fabsf(scale.x), fabsf(scale.y), fabsf(scale.z) });
+        float distance = Vector3Distance(camera.position, transform.position);
+        lod.level = lod.group->Select(lod.level, cs381::ScreenSize(radius, distance, camera.fovy));
+    });
+}
+
+Quaternion EntityRotation(EntityID e) {
+    if (world.HasComponent<Physics3DComponent>(e)) return world.GetComponent<Physics3DComponent>(e).rotation;  // Rocket's orientation
+    if (world.HasComponent<Physics2DComponent>(e)) return QuaternionFromAxisAngle({ 0, 1, 0 }, world.GetComponent<Physics2DComponent>(e).heading * DEG2RAD);  // Car's heading
+    return QuaternionIdentity();
+}
+
+// Runs before every simulation tick, so RenderSystem can blend from the state the tick started with
+void PreviousTransformSystem() {
+    world.View<TransformComponent, PreviousTransformComponent>().ForEach([](EntityID e, TransformComponent& transform, PreviousTransformComponent& previous) {
+        previous = { transform.position, EntityRotation(e) };
+    });
+}
+
+// Where the entity is drawn, alpha of the way from its previous tick to its current one (see FixedTimestep::Alpha)
+Vector3 DrawnPosition(EntityID e, float alpha) {
+    Vector3 position = world.GetComponent<TransformComponent>(e).position;
+    if (!world.HasComponent<PreviousTransformComponent>(e)) return position;
+    return Vector3Lerp(world.GetComponent<PreviousTransformComponent>(e).position, position, alpha);
+}
 
-            if (selectionPool[e]) {
-                DrawBoundingBox(renderPool[e].model->GetBoundingBox(), RED);
+Quaternion DrawnRotation(EntityID e, float alpha) {
+    if (!world.HasComponent<PreviousTransformComponent>(e)) return EntityRotation(e);
+    return QuaternionSlerp(world.GetComponent<PreviousTransformComponent>(e).rotation, EntityRotation(e), alpha);
+}
+
+// A single entity's world matrix, the same scale, rotate, translate order RenderSystem builds in bulk
+Matrix EntityMatrix(EntityID e) {
+    auto& transform = world.GetComponent<TransformComponent>(e);
+    Matrix matrix = MatrixMultiply(MatrixScale(transform.scale.x, transform.scale.y, transform.scale.z), QuaternionToMatrix(EntityRotation(e)));
+    return MatrixMultiply(matrix, MatrixTranslate(transform.position.x, transform.position.y, transform.position.z));
+}
+
+// Box around the entity's bounding sphere, it only changes when the entity moves (not when it turns)
+BoundingBox EntityBounds(EntityID e) {
+    auto& transform = world.GetComponent<TransformComponent>(e);
+    Vector3 scale = transform.scale;
+    float radius = modelBounds.Get(*world.GetComponent<RenderComponent>(e).model).radius * std::max({ fabsf(scale.x), fabsf(scale.y), fabsf(scale.z) });
+    Vector3 extent = { radius, radius, radius };
+    return { Vector3Subtract(transform.position, extent), Vector3Add(transform.position, extent) };
+}
+
+// Every drawable entity's bounds, for culling and picking (see BVH.hpp)
+cs381::BVH entityTree;
+std::vector<uint32_t> treeResults;
+
+// Refits the tree to where entities moved, and rebuilds it when entities were added or refitting made it too loose
+void SpatialIndexSystem() {
+    bool rebuild = false;
+    auto drawable = world.View<TransformComponent, RenderComponent>();
+    drawable.ForEach([&rebuild](EntityID e, TransformComponent&, RenderComponent&) {
+        if (!entityTree.Contains(e)) rebuild = true;
+        else entityTree.Update(e, EntityBounds(e));
+    });
+    if (!rebuild && !entityTree.Degraded()) return;
+
+    std::vector<uint32_t> ids;
+    std::vector<BoundingBox> boxes;
+    drawable.ForEach([&](EntityID e, TransformComponent&, RenderComponent&) {
+        ids.push_back(e);
+        boxes.push_back(EntityBounds(e));
+    });
+    entityTree.Build(ids, boxes);
+}
+
+// World matrices of the entities that survived culling, rebuilt every frame by RenderSystem
+// Visible entities are sorted by the model they draw, so each model's instances form one contiguous range of matrices
+// which the renderer reads in place (see InstancedRenderer::Submit)
+struct VisibleEntity {
+    const ::Model* model;  // After LOD selection
+    EntityID entity;
+};
+std::vector<VisibleEntity> visibleEntities;
+cs381::batch::Vector3Array visibleTranslations, visibleScales;
+cs381::batch::QuaternionArray visibleRotations;
+std::vector<Matrix> worldMatrices;  // worldMatrices[i] belongs to visibleEntities[i]
+
+// Entities are submitted to the instanced renderer, which draws each distinct model once (see InstancedRenderer.hpp)
+// Entities outside the camera's frustum are skipped before any matrix work, the entity tree only returns those whose
+// bounds reach into it, which are then tested against their bounding sphere
+// The remaining entities get their world matrices in one batched pass, straight from position, rotation and scale
+// Bounds are added to debug, which draws them once the scene is done
+// With an occlusion buffer (already rasterized for this frame) entities hidden behind its occluders are skipped too
+// With an impostor renderer, entities further than impostorDistance which have an atlas are drawn as its quads instead
+// Entities are drawn alpha of the way between their last two simulation ticks (the tree holds their current bounds)
+void RenderSystem(cs381::InstancedRenderer& renderer, cs381::DebugDraw& debug, cs381::OcclusionBuffer* occlusion,
+        cs381::ImpostorRenderer* impostors, float impostorDistance, float alpha) {
+    cs381::Frustum frustum = cs381::Frustum::Current();
+    culledEntities = 0;
+    occludedEntities = 0;
+    impostorEntities = 0;
+    std::fill_n(lodEntities, MAX_LOD_LEVELS, 0);
+    std::fill_n(lodTriangles, MAX_LOD_LEVELS, 0);
+
+    treeResults.clear();
+    entityTree.Visible(frustum, treeResults);
+    culledEntities = entityTree.Size() - treeResults.size();
+
+    visibleEntities.clear();
+    for (EntityID e : treeResults) {
+        // The bounding sphere only needs position and scale, so it works before the matrix is built
+        const ::Model* model = world.GetComponent<RenderComponent>(e).model;
+        const cs381::ModelBounds& bounds = modelBounds.Get(*model);
+        Vector3 scale = world.GetComponent<TransformComponent>(e).scale;
+        float maxScale = std::max({ fabsf(scale.x), fabsf(scale.y), fabsf(scale.z) });
+        if (!frustum.ContainsSphere(DrawnPosition(e, alpha), bounds.radius * maxScale)) {
+            culledEntities++;
+            continue;
+        }
+
+        // Culling always uses the full model's bounds, levels only drop detail
+        if (world.HasComponent<LODComponent>(e)) {
+            auto& lod = world.GetComponent<LODComponent>(e);
+            model = &lod.group->Model(lod.level);
+        }
+        visibleEntities.push_back({ model, e });
+    }
+    std::sort(visibleEntities.begin(), visibleEntities.end(), [](const VisibleEntity& a, const VisibleEntity& b) {
+        return std::less<const ::Model*>{}(a.model, b.model) || (a.model == b.model && a.entity < b.entity);
+    });
+
+    // Gather the inputs in draw order, then build every matrix at once
+    visibleTranslations.clear();
+    visibleRotations.clear();
+    visibleScales.clear();
+    for (auto [model, e] : visibleEntities) {
+        visibleTranslations.push_back(DrawnPosition(e, alpha));
+        visibleRotations.push_back(DrawnRotation(e, alpha));
+        visibleScales.push_back(world.GetComponent<TransformComponent>(e).scale);
+    }
+    worldMatrices.resize(visibleEntities.size());
+    cs381::batch::ComposeTRS(visibleTranslations, visibleRotations, visibleScales, worldMatrices);
+
+    // The box test needs the matrix, entities failing it are compacted out (keeping the model ranges contiguous)
+    EntityID selected = entityOrder[selectedIndex];
+    size_t visible = 0;
+    for (size_t i = 0; i < visibleEntities.size(); ++i) {
+        EntityID e = visibleEntities[i].entity;
+        BoundingBox worldBounds = cs381::TransformBounds(modelBounds.Get(*world.GetComponent<RenderComponent>(e).model).box, worldMatrices[i]);
+        if (!frustum.ContainsBox(worldBounds)) {  // Tighter than the sphere
+            culledEntities++;
+            continue;
+        }
+        if (occlusion && !occlusion->Visible(worldBounds)) {
+            occludedEntities++;
+            continue;
+        }
+
+        if (e == selected) {
+            debug.Box(worldBounds, RED);
+        } else if (showAllBounds) {
+            debug.Box(worldBounds, DARKGREEN);
+        }
+        if (showAllBounds) debug.Axes(worldMatrices[i]);
+
+        Vector3 position = visibleTranslations.Get(i);
+        if (impostors && world.HasComponent<ImpostorComponent>(e) && Vector3Distance(camera.position, position) > impostorDistance) {
+            impostors->Submit(*world.GetComponent<ImpostorComponent>(e).atlas, position, visibleRotations.Get(i), visibleScales.Get(i), camera.position);
+            impostorEntities++;
+            continue;
+        }
+        if (world.HasComponent<LODComponent>(e)) {
+            auto& lod = world.GetComponent<LODComponent>(e);
+            if (lod.level < MAX_LOD_LEVELS) {
+                lodEntities[lod.level]++;
+                lodTriangles[lod.level] += lod.group->levels[lod.level].triangles;
             }
         }
+
+        visibleEntities[visible] = visibleEntities[i];
+        worldMatrices[visible++] = worldMatrices[i];
+    }
+    visibleEntities.resize(visible);
+    worldMatrices.resize(visible);
+
+    for (size_t begin = 0, end; begin < visible; begin = end) {
+        for (end = begin + 1; end < visible && visibleEntities[end].model == visibleEntities[begin].model; ++end);
+        renderer.Submit(*visibleEntities[begin].model, std::span<const Matrix>(worldMatrices).subspan(begin, end - begin));
     }
 }
 
 
-void InputSystem(float dt) {
+// stop is whether SPACE was pressed since the last tick (frames without a tick must not lose the press)
+void InputSystem(float dt, bool stop) {
     EntityID selected = entityOrder[selectedIndex];
-    if (!hasVelocity[selected]) return;
+    if (!world.HasComponent<VelocityComponent>(selected)) return;
 
-    auto& vel = velocityPool[selected];
+    auto& vel = world.GetComponent<VelocityComponent>(selected);
 
-    if (hasPhysics2D[selected]) {
+    if (world.HasComponent<Physics2DComponent>(selected)) {
         if (IsKeyDown(KEY_W)) vel.speed = std::min(vel.speed + vel.acceleration * dt, vel.maxSpeed);
         if (IsKeyDown(KEY_S)) vel.speed = std::max(vel.speed - vel.acceleration * dt, -vel.maxSpeed);
 
-        auto& phys = physics2DPool[selected];
+        auto& phys = world.GetComponent<Physics2DComponent>(selected);
         if (IsKeyDown(KEY_A)) phys.heading += phys.turnRate * dt;
         if (IsKeyDown(KEY_D)) phys.heading -= phys.turnRate * dt;
     }
 
-    if (hasPhysics3D[selected]) {
+    if (world.HasComponent<Physics3DComponent>(selected)) {
         // Movement for the rocket (continue moving even if no keys are pressed)
         if (IsKeyDown(KEY_W)) {
             vel.velocity.y = std::min(vel.velocity.y + vel.acceleration * dt, vel.maxSpeed);
@@ -196,12 +463,12 @@ void InputSystem(float dt) {
         }
 
         // Stop rocket movement when Space is pressed
-        if (IsKeyPressed(KEY_SPACE)) {
+        if (stop) {
             vel.velocity = {0.0f, 0.0f, 0.0f};  // Explicitly set all velocity components to zero
         }
 
         // Apply angular rotations for rocket (yaw, pitch, roll)
-        auto& phys = physics3DPool[selected];
+        auto& phys = world.GetComponent<Physics3DComponent>(selected);
         if (IsKeyDown(KEY_A)) phys.angular.y += 1 * dt;  // Yaw
         if (IsKeyDown(KEY_D)) phys.angular.y -= 1 * dt;  // Yaw
         if (IsKeyDown(KEY_R)) phys.angular.x += 1 * dt;  // Pitch
@@ -210,30 +477,93 @@ void InputSystem(float dt) {
         if (IsKeyDown(KEY_E)) phys.angular.z -= 1 * dt;  // Roll
     }
 
-    if (IsKeyPressed(KEY_SPACE)) vel.speed = 0.0f;  // Stop car if space is pressed
+    if (stop) vel.speed = 0.0f;  // Stop car if space is pressed
+}
+
+size_t pickTests = 0;  // Entities the last click tested against their meshes
+
+// Nearest entity under the mouse, or NO_ENTITY. The tree only hands over entities whose bounds the ray passes
+// through (nearest first), and only those are tested against their actual triangles
+EntityID PickEntity(Vector2 mouse) {
+    Ray ray = GetScreenToWorldRay(mouse, camera);
+    pickTests = 0;
+    cs381::BVH::Hit hit = entityTree.Raycast(ray, INFINITY, [&ray](uint32_t e) {
+        pickTests++;
+        const ::Model& model = *world.GetComponent<RenderComponent>(e).model;
+        Matrix transform = EntityMatrix(e);
+        float distance = INFINITY;
+        for (int m = 0; m < model.meshCount; ++m) {
+            RayCollision collision = GetRayCollisionMesh(ray, model.meshes[m], transform);
+            if (collision.hit) distance = std::min(distance, collision.distance);
+        }
+        return distance;
+    });
+    return hit.id;
+}
+
+void Select(size_t index) {
+    selectedIndex = index;
 }
 
 void SelectionSystem() {
     if (IsKeyPressed(KEY_TAB)) {
-        selectionPool[entityOrder[selectedIndex]] = false;
-        selectedIndex = (selectedIndex + 1) % entityOrder.size();
-        selectionPool[entityOrder[selectedIndex]] = true;
+        Select((selectedIndex + 1) % entityOrder.size());
+    }
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        EntityID picked = PickEntity(GetMousePosition());
+        auto it = std::find(entityOrder.begin(), entityOrder.end(), picked);
+        if (it != entityOrder.end()) Select(it - entityOrder.begin());
     }
 }
 
-int main() {
+// Usage: as8 [extra cars], extra cars are parked in rows behind the vehicles (TAB cycles through them too)
+int main(int argc, char** argv) {
+    int extraCars = argc > 1 ? std::max(std::atoi(argv[1]), 0) : 0;
     raylib::Window window(SCREEN_WIDTH, SCREEN_HEIGHT, "CS381 - Assignment 8");
     SetTargetFPS(60);
     camera = raylib::Camera3D({0.0f, 10.0f, 30.0f}, {0, 0, 0}, {0.0f, 1.0f, 0.0f}, 45.0f, CAMERA_PERSPECTIVE);
 
-    carModels[0] = raylib::Model("../assets/Kenny Car Kit/ambulance.glb");
-    carModels[1] = raylib::Model("../assets/Kenny Car Kit/police.glb");
-    carModels[2] = raylib::Model("../assets/Kenny Car Kit/taxi.glb");
-    carModels[3] = raylib::Model("../assets/Kenny Car Kit/suv.glb");
-    carModels[4] = raylib::Model("../assets/Kenny Car Kit/sedan.glb");
-    rocketModel = raylib::Model("../assets/Kenny Space Kit/rocketA.glb");
+    const char* carPaths[5] = { "../assets/Kenny Car Kit/ambulance.glb", "../assets/Kenny Car Kit/police.glb", "../assets/Kenny Car Kit/taxi.glb",
+        "../assets/Kenny Car Kit/suv.glb", "../assets/Kenny Car Kit/sedan.glb" };
+    const char* rocketPath = "../assets/Kenny Space Kit/rocketA.glb";
+    for (int i = 0; i < 5; i++) carModels[i] = raylib::Model(carPaths[i]);
+    rocketModel = raylib::Model(rocketPath);
+    for (auto& model : carModels) modelBounds.Get(model);  // Bounds are computed once, here, instead of every frame
+    modelBounds.Get(rocketModel);
+
+    std::unique_ptr<cs381::LODGroup> carLODs[5];
+    for (int i = 0; i < 5; i++) carLODs[i] = LoadLODs(carModels[i], carPaths[i]);
+    auto rocketLODs = LoadLODs(rocketModel, rocketPath);
 
     cs381::SkyBox sky("textures/skybox.png");
+    cs381::InstancedRenderer renderer;
+    renderer.Init();
+    cs381::ImpostorRenderer impostors;
+    impostors.Init();
+    std::unique_ptr<cs381::ImpostorAtlas> carImpostors[5];
+    for (int i = 0; i < 5; i++) carImpostors[i] = LoadImpostor(carModels[i], carPaths[i]);
+    auto rocketImpostor = LoadImpostor(rocketModel, rocketPath);
+    int impostorAtlases = 1, cachedImpostors = rocketImpostor->cached;
+    for (auto& atlas : carImpostors) {
+        impostorAtlases++;
+        cachedImpostors += atlas->cached;
+    }
+    cs381::RenderQueue queue;
+    cs381::DebugDraw debug;
+    debug.Init();
+
+    LayoutBase();
+    cs381::StaticBatch staticBatch;
+    for (auto& piece : basePieces) staticBatch.Add(*piece.model, piece.transform);
+    staticBatch.Build();
+    bool staticBatching = true;
+
+    cs381::OcclusionBuffer occlusion;
+    for (auto& piece : basePieces)
+        if (piece.occluder)
+            for (int m = 0; m < piece.model->meshCount; m++) occlusion.AddOccluder(piece.model->meshes[m], piece.transform);
+    cs381::FrameWorkerPool workers;
+    bool occlusionCulling = true;
 
     raylib::Model grass = raylib::Mesh::Plane(100, 100, 1, 1).LoadModelFrom();
     raylib::Texture grassTexture = raylib::Texture("../assets/textures/grass.jpg");
@@ -243,33 +573,87 @@ int main() {
         float speed = 10 + i * 2;
         float accel = 4 + i;
         float turn = 60 - i * 5;
-        CreateCar({ (float)i * 4.0f, 0, 0 }, speed, accel, turn, carModels[i]);
+        EntityID car = CreateCar({ (float)i * 4.0f, 0, 0 }, speed, accel, turn, carModels[i]);
+        AttachLOD(car, *carLODs[i]);
+        AttachImpostor(car, *carImpostors[i]);
     }
 
     for (int i = 0; i < 5; i++) {
-        CreateRocket({ (float)i * 4.0f, 0, -6 }, rocketModel);
+        EntityID rocket = CreateRocket({ (float)i * 4.0f, 0, -6 }, rocketModel);
+        AttachLOD(rocket, *rocketLODs);
+        AttachImpostor(rocket, *rocketImpostor);
     }
 
-    selectionPool[entityOrder[0]] = true;
+    for (int i = 0; i < extraCars; i++) {
+        int model = i % 5;
+        EntityID car = CreateCar({ -46.0f + (i % 24) * 4.0f, 0, -12.0f - (i / 24) * 4.0f }, 10, 4, 60, carModels[model]);
+        AttachLOD(car, *carLODs[model]);
+        AttachImpostor(car, *carImpostors[model]);
+    }
+
+    SpatialIndexSystem();
 
+    cs381::FixedTimestep timestep;  // Vehicles move in 60 Hz ticks whatever the frame rate (see FixedTimestep.hpp)
+    bool stopPressed = false;
     while (!window.ShouldClose()) {
-        float dt = GetFrameTime();
 
+        if (IsKeyPressed(KEY_I)) renderer.instancing = !renderer.instancing;
+        if (IsKeyPressed(KEY_F1)) debug.enabled = !debug.enabled;
+        if (IsKeyPressed(KEY_F2)) showAllBounds = !showAllBounds;
+        if (IsKeyPressed(KEY_M)) staticBatching = !staticBatching;
+        if (IsKeyPressed(KEY_O)) occlusionCulling = !occlusionCulling;
+        if (IsKeyPressed(KEY_P)) impostorSetting = (impostorSetting + 1) % std::size(IMPOSTOR_DISTANCES);
         SelectionSystem();
-        InputSystem(dt);
-        Physics2DSystem(dt);
-        Physics3DSystem(dt);
-        KinematicsSystem(dt);
+        stopPressed |= IsKeyPressed(KEY_SPACE);
+        for (int steps = timestep.Advance(GetFrameTime()); steps > 0; --steps) {
+            float dt = timestep.StepSize();
+            PreviousTransformSystem();
+            InputSystem(dt, stopPressed);
+            stopPressed = false;
+            Physics2DSystem(dt);
+            Physics3DSystem(dt);
+            KinematicsSystem(dt);
+        }
+        LODSystem();
+        SpatialIndexSystem();
 
         window.BeginDrawing();
         window.ClearBackground(RAYWHITE);
         camera.BeginMode();
 
-        sky.Draw();
-        grass.Draw({});
-        RenderSystem();
+        renderer.Begin();
+        impostors.Begin();
+        renderer.Submit(grass, MatrixIdentity());
+        if (occlusionCulling) occlusion.Rasterize(cs381::Frustum::ViewProjection(camera, (float)GetScreenWidth() / GetScreenHeight()), &workers);
+        RenderSystem(renderer, debug, occlusionCulling ? &occlusion : nullptr, impostors.Supported() ? &impostors : nullptr, IMPOSTOR_DISTANCES[impostorSetting], timestep.Alpha());
+        if (staticBatching) {
+            staticBatch.Enqueue(queue, cs381::Frustum::Current(), camera.position);
+        } else {
+            staticBatch.stats.drawn = 0;
+            for (auto& piece : basePieces) renderer.Submit(*piece.model, piece.transform);
+        }
+        renderer.Enqueue(queue, camera.position);
+        impostors.Enqueue(queue, camera.position);
+        queue.Add(cs381::RenderQueue::Key(cs381::RenderQueue::Sky, 0, 0, 0), [&sky] { sky.Draw(); });  // Last, only fills what nothing else covered
+        queue.Submit();
+        debug.Flush();
 
         camera.EndMode();
+        DrawText(TextFormat("Draw calls: %zu  Models: %zu  Culled: %zu  Triangles: %zu  Instancing (I): %s", renderer.stats.drawCalls, renderer.stats.instances,
+            culledEntities, renderer.stats.triangles, renderer.instancing && renderer.Supported() ? "on" : "off"), 10, 10, 10, DARKGRAY);
+        DrawText(TextFormat("Queue: %zu items, %zu state changes  Debug lines: %zu  All bounds (F2): %s  Debug draw (F1): %s", queue.stats.items,
+            queue.stats.stateChanges, debug.lines, showAllBounds ? "on" : "off", debug.enabled ? "on" : "off"), 10, 38, 10, DARKGRAY);
+        DrawText(TextFormat("Static batching (M): %s  Base: %zu pieces in %zu meshes, %zu drawn", staticBatching ? "on" : "off", staticBatch.stats.pieces,
+            staticBatch.stats.meshes, staticBatch.stats.drawn), 10, 52, 10, DARKGRAY);
+        DrawText(TextFormat("Last click tested %zu of %zu entities", pickTests, entityTree.Size()), 10, 66, 10, DARKGRAY);
+        DrawText(TextFormat("Occlusion culling (O): %s  Occluders: %zu triangles  Hidden: %zu", occlusionCulling ? "on" : "off", occlusion.OccluderTriangles(),
+            occludedEntities), 10, 80, 10, DARKGRAY);
+        const char* impostorMode = !impostors.Supported() ? "unsupported" : std::isinf(IMPOSTOR_DISTANCES[impostorSetting]) ? "off"
+            : TextFormat("beyond %.0f", IMPOSTOR_DISTANCES[impostorSetting]);
+        DrawText(TextFormat("Impostors (P): %s  Drawn: %zu in %zu draw calls  Atlases loaded from cache: %d of %d", impostorMode, impostorEntities,
+            impostors.stats.drawCalls, cachedImpostors, impostorAtlases), 10, 94, 10, DARKGRAY);
+        DrawText(TextFormat("LOD0: %zu (%zu tris)  LOD1: %zu (%zu tris)  LOD2: %zu (%zu tris)", lodEntities[0], lodTriangles[0],
+            lodEntities[1], lodTriangles[1], lodEntities[2], lodTriangles[2]), 10, 24, 10, DARKGRAY);
         window.EndDrawing();
     }
     return 0;
@@ -0,0 +1,52 @@
+// Checks the software occlusion buffer (OcclusionBuffer.hpp) against a single wall in front of the camera: boxes behind
+// it are hidden, boxes in front of, beside or partly behind it stay visible
+// Exits with a non zero status if any check fails, run by ctest (or by hand as as8_occlusion_test)
+
+#include "OcclusionBuffer.hpp"
+#include <raymath.h>
+#include <iostream>
+
+using namespace cs381;
+
+static int failures = 0;
+
+static void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::cerr << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+static BoundingBox Box(Vector3 center, float halfSize) {
+    return { Vector3SubtractValue(center, halfSize), Vector3AddValue(center, halfSize) };
+}
+
+int main() {
+    // A wall facing the camera 10 units away, drawn as two triangles
+    float wallVertices[] = { -5.1f, -5.1f, -10, 5.1f, -5.1f, -10, 5.1f, 5.1f, -10, -5.1f, 5.1f, -10 };
+    unsigned short wallIndices[] = { 0, 1, 2, 0, 2, 3 };
+    Mesh wall = {};
+    wall.vertexCount = 4;
+    wall.triangleCount = 2;
+    wall.vertices = wallVertices;
+    wall.indices = wallIndices;
+
+    OcclusionBuffer buffer(256, 128);
+    buffer.AddOccluder(wall, MatrixIdentity());
+    Matrix viewProjection = MatrixMultiply(MatrixLookAt({ 0, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 }),
+        MatrixPerspective(60 * DEG2RAD, 2.0, 0.01, 1000));
+
+    FrameWorkerPool pool(2);
+    buffer.Rasterize(viewProjection, &pool);
+    Check(buffer.stats.triangles == 2, "both wall triangles are drawn");
+
+    Check(!buffer.Visible(Box({ 0, 0, -20 }, 1)), "a box behind the wall is hidden");
+    Check(buffer.Visible(Box({ 0, 0, -5 }, 1)), "a box in front of the wall is visible");
+    Check(buffer.Visible(Box({ 12, 0, -20 }, 1)), "a box beside the wall is visible");
+    Check(buffer.Visible(Box({ 0, 0, -10.5f }, 1)), "a box poking through the wall is visible");
+    Check(buffer.Visible(Box({ 10.2f, 0, -20 }, 1)), "a box half behind the wall's edge is visible");
+    Check(!buffer.Visible(Box({ 4, 4, -30 }, 2)), "a box behind the wall's diagonal is hidden");
+
+    if (failures == 0) std::cout << "all occlusion checks passed\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -11,18 +11,147 @@
 #include <span>
 #include <variant>
 #include <cassert>
+#include <atomic>
+#include <limits>
+#include <cstring>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
 
 extern size_t globalComponentCounter;
 
 namespace cs381 {
 
 	template<typename T>  // Template function for component ID retrieval
-	size_t GetComponentID(T reference = {}) {  // Function to get component ID
+	size_t GetComponentID() {  // Function to get component ID (doesn't need T to be default constructible)
 		static size_t id = globalComponentCounter++;  // Static variable to ensure ID is unique
 		return id;  // Return unique component ID
 	}
 
-	using Entity = uint8_t;  // Alias for entity type, used for representing entities as uint8_t
+	template<typename T>  // Component ID of an existing component
+	size_t GetComponentID(const T& reference) { return GetComponentID<T>(); }
+
+	using Entity = uint32_t;  // Alias for entity type, used for representing entities as uint32_t
+
+	// EntityReservation hands out entity IDs without locking, IDs are only backed by storage once the scene is synced
+	struct EntityReservation {
+		static constexpr size_t BatchSize = 64;  // Number of IDs each thread grabs from the shared counter at once
+
+		std::atomic<size_t> next = 0;  // First ID which has not been handed out yet
+		size_t owner = NewOwner();  // Unique tag used to tell which reservation a thread's batch came from
+
+		EntityReservation() = default;
+		EntityReservation(const EntityReservation& other) : next(other.next.load(std::memory_order_relaxed)) {}  // Copies get a fresh owner so cached batches are never shared
+		EntityReservation& operator=(const EntityReservation& other) {
+			next.store(other.next.load(std::memory_order_relaxed), std::memory_order_relaxed);  // Copy the counter
+			owner = NewOwner();  // Invalidate any batches cached against the old counter
+			return *this;
+		}
+
+		Entity Reserve() {  // Reserve a single ID, safe to call from any thread
+			struct Batch { size_t owner = 0, next = 0, end = 0; };  // Range of IDs owned by the calling thread
+			thread_local Batch batch;
+			if(batch.owner != owner || batch.next == batch.end) {  // Out of IDs (or the batch belongs to another scene), grab a new batch
+				batch.next = next.fetch_add(BatchSize, std::memory_order_relaxed);
+				batch.end = batch.next + BatchSize;
+				batch.owner = owner;
+			}
+			return batch.next++;  // Hand out the next ID from the batch
+		}
+
+		size_t Reserved() const { return next.load(std::memory_order_acquire); }  // Number of IDs handed out so far
+
+	private:
+		static size_t NewOwner() {
+			static std::atomic<size_t> counter = 1;  // Zero is reserved for "no batch"
+			return counter.fetch_add(1, std::memory_order_relaxed);
+		}
+	};
+
+	// Components can opt into being stored as one column per field by specializing SplitComponent with a tuple of member pointers:
+	//   template<> struct cs381::SplitComponent<TransformComponent> {
+	//       static constexpr auto fields = std::make_tuple(&TransformComponent::position, &TransformComponent::rotation, &TransformComponent::scale);
+	//   };
+	// Systems that only touch some fields can then stream just those columns (see Scene::GetFieldStorage)
+	template<typename Tcomponent>
+	struct SplitComponent {};
+
+	template<typename Tcomponent>  // Concept satisfied by components which have been split into field columns
+	concept SplitComponentType = requires { SplitComponent<Tcomponent>::fields; };
+
+	template<typename Tcomponent>  // Index sequence covering each of a split component's fields
+	using SplitFieldIndices = std::make_index_sequence<std::tuple_size_v<std::remove_cv_t<decltype(SplitComponent<Tcomponent>::fields)>>>;
+
+	template<typename Tfield> struct FieldTraits;  // Pulls the owning component and value type out of a member pointer
+	template<typename Tcomponent, typename Tvalue>
+	struct FieldTraits<Tvalue Tcomponent::*> {
+		using Component = Tcomponent;
+		using Type = Tvalue;
+	};
+
+	template<auto Field>  // Every field column gets its own component ID through this tag
+	struct FieldTag {};
+
+	// SplitView is the proxy returned in place of a reference when a split component is requested
+	// Like a reference it aliases the entity: `auto view = GetComponent<T>(e)` is another view of e, not a copy of its
+	// values (convert it, `T value = GetComponent<T>(e)`, for that), and assigning one view to another copies the values
+	template<typename Tcomponent, typename Tfields = std::remove_cv_t<decltype(SplitComponent<Tcomponent>::fields)>>
+	struct SplitView;
+	template<typename Tcomponent, typename... Tfields>
+	struct SplitView<Tcomponent, std::tuple<Tfields...>> {
+		static constexpr auto& fields = SplitComponent<Tcomponent>::fields;  // The member pointers this view maps to columns
+		std::tuple<typename FieldTraits<Tfields>::Type*...> columns;  // Pointer to this entity's value in each column
+
+		template<size_t I>  // Access a field by its index in the field list
+		auto& Get() { return *std::get<I>(columns); }
+
+		template<auto Member>  // Access a field by member pointer, ex: view.Field<&TransformComponent::position>()
+		auto& Field() { return Get<IndexOf<Member>()>(); }
+
+		operator Tcomponent() const {  // Gather the fields back into a full component
+			Tcomponent out{};
+			[&]<size_t... I>(std::index_sequence<I...>) {
+				((out.*std::get<I>(fields) = *std::get<I>(columns)), ...);
+			}(std::index_sequence_for<Tfields...>{});
+			return out;
+		}
+
+		SplitView(std::tuple<typename FieldTraits<Tfields>::Type*...> columns) : columns(columns) {}
+		SplitView(const SplitView&) = default;  // Another view of the same entity
+
+		SplitView& operator=(const SplitView& other) {  // Copy the other entity's values, not the column pointers
+			[&]<size_t... I>(std::index_sequence<I...>) {
+				((*std::get<I>(columns) = *std::get<I>(other.columns)), ...);
+			}(std::index_sequence_for<Tfields...>{});
+			return *this;
+		}
+
+		SplitView& operator=(const Tcomponent& value) {  // Scatter a full component out to the columns
+			[&]<size_t... I>(std::index_sequence<I...>) {
+				((*std::get<I>(columns) = value.*std::get<I>(fields)), ...);
+			}(std::index_sequence_for<Tfields...>{});
+			return *this;
+		}
+
+	private:
+		template<auto Member, size_t I = 0>  // Position of a member pointer in the field list
+		static constexpr size_t IndexOf() {
+			static_assert(I < sizeof...(Tfields), "Field is not part of this component's split");
+			if constexpr(std::is_same_v<decltype(Member), std::tuple_element_t<I, std::tuple<Tfields...>>>)
+				if constexpr(std::get<I>(fields) == Member)
+					return I;
+				else return IndexOf<Member, I + 1>();
+			else return IndexOf<Member, I + 1>();
+		}
+	};
+
+	template<typename Tcomponent, bool split = SplitComponentType<Tcomponent>>
+	struct ComponentReferenceImpl { using type = Tcomponent&; };
+	template<typename Tcomponent>
+	struct ComponentReferenceImpl<Tcomponent, true> { using type = SplitView<Tcomponent>; };
+	template<typename Tcomponent>  // What GetComponent hands back: a plain reference, or a SplitView for split components
+	using ComponentReference = typename ComponentReferenceImpl<Tcomponent>::type;
 
 	// ComponentStorage structure handles storing components of entities
 	struct ComponentStorage {
@@ -45,7 +174,6 @@ namespace cs381 {
 		template<typename Tcomponent>  // Function to allocate memory for components
 		std::pair<Tcomponent&, size_t> Allocate(size_t count = 1) {
 			assert(sizeof(Tcomponent) == elementSize);  // Ensure element size matches
-			assert(count < 100);  // Ensure count is reasonable
 			auto originalEnd = data.size();  // Save the current size of data
 			data.insert(data.end(), elementSize * count, std::byte{0});  // Insert space for components
 			for(size_t i = 0; i < count - 1; i++)  // Initialize all but the last component
@@ -64,53 +192,156 @@ namespace cs381 {
 				Allocate<Tcomponent>(std::max<int64_t>(int64_t(e) - size + 1, 1));
 			return Get<Tcomponent>(e);  // Return the component
 		}
+
+		std::byte* GetRaw(Entity e) {  // Untyped access to an entity's component bytes
+			assert(e < (data.size() / elementSize));  // Ensure entity index is within bounds
+			return data.data() + e * elementSize;
+		}
+
+		template<typename Tcomponent>  // View the whole storage as a contiguous array indexed by entity
+		std::span<Tcomponent> Span() {
+			assert(sizeof(Tcomponent) == elementSize);  // Ensure element size matches
+			return {(Tcomponent*)data.data(), data.size() / elementSize};
+		}
+
+		std::byte* GetOrAllocateRaw(Entity e) {  // Untyped get or allocate, new slots are zero filled
+			if (data.size() / elementSize <= e)  // Grow to cover the entity
+				data.resize((size_t(e) + 1) * elementSize, std::byte{0});
+			return GetRaw(e);
+		}
 	};
 
+	template<typename Storage, typename... Tcomponents>
+	struct BasicSceneView;
+
 	// Scene structure manages entities and their components
+	// Component IDs are global, so every scene shares one component registry and entities can be migrated between them
 	template<typename Storage = ComponentStorage>  // Default to using ComponentStorage for the component data
 	struct Scene {
 		std::vector<std::vector<bool>> entityMasks;  // Masks to track components for each entity
+		std::vector<std::vector<Entity>> componentEntities;  // For each component ID, the entities which have it (ascending), views walk these instead of every mask
 		std::vector<Storage> storages = {Storage()};  // Vector of component storages
+		std::vector<Storage> writeStorages;  // Back buffers of double buffered components, indexed like storages
+		std::vector<bool> buffering;  // Which back buffers have been started this tick, indexed like storages
+		EntityReservation reservation;  // Lock-free ID counter shared by all threads spawning into this scene
 
 		template<typename Tcomponent>  // Get the storage for a specific component
 		Storage& GetStorage() {
-			size_t id = GetComponentID<Tcomponent>();  // Get the component ID
+			return GetStorage(GetComponentID<Tcomponent>(), sizeof(Tcomponent));
+		}
+
+		Storage& GetStorage(size_t id, size_t elementSize) {  // Get the storage for a component ID, creating it with the given element size
 			if(storages.size() <= id)  // If storage is not large enough, add more
-				storages.insert(storages.cend(), std::max<int64_t>(id - storages.size(), 1), Storage());
+				storages.resize(id + 1, Storage());
 			if (storages[id].elementSize == std::numeric_limits<size_t>::max())  // If element size is uninitialized, initialize it
-				storages[id] = Storage(Tcomponent{});
+				storages[id] = Storage(elementSize);
+			assert(storages[id].elementSize == elementSize);  // Ensure every scene agrees on the component's size
 			return storages[id];  // Return the storage for the component
 		}
 
-		Entity CreateEntity() {  // Create a new entity and return its ID
-			Entity e = entityMasks.size();  // Use the size of entityMasks as the entity ID
-			entityMasks.emplace_back(std::vector<bool>{false});  // Add a new mask for the entity
+		Entity CreateEntity() {  // Create a new entity and return its ID (main thread only)
+			Entity e = reservation.next.fetch_add(1, std::memory_order_relaxed);  // Take the next ID from the shared counter
+			SyncEntities();  // Back it (and any pending reservations) with a mask
 			return e;  // Return the new entity ID
 		}
 
+		Entity ReserveEntity() {  // Reserve an entity ID from any thread, components may be added after the next SyncEntities
+			return reservation.Reserve();
+		}
+
+		std::vector<Entity> CreateEntities(size_t count) {  // Create several consecutive entities at once (main thread only)
+			Entity first = reservation.next.fetch_add(count, std::memory_order_relaxed);  // Take the whole range in one go
+			SyncEntities();
+			std::vector<Entity> out(count);
+			for(size_t i = 0; i < count; i++)
+				out[i] = first + i;
+			return out;
+		}
+
+		void SyncEntities() {  // Grow the masks to cover every reserved ID (main thread only), IDs reserved meanwhile are picked up by the next sync
+			size_t reserved = reservation.Reserved();
+			if(entityMasks.size() < reserved)  // IDs in unused batch slots simply become empty entities
+				entityMasks.resize(reserved, std::vector<bool>{false});
+		}
+
+		// Move entities (and all of their components) into another scene, returns the entities' new IDs in the same order
+		// Component data is moved one storage at a time so each storage is walked once no matter how many entities move
+		// The source entities are left behind empty
+		// Neither scene may be between BeginWrite and SwapBuffers: the back buffers aren't migrated, so the swap would undo the move
+		std::vector<Entity> MigrateEntities(std::span<const Entity> entities, Scene& dst) {
+			assert(&dst != this);  // Migrating into ourselves would just shuffle IDs
+			assert(!IsBuffering() && !dst.IsBuffering());  // Finish the tick (SwapBuffers) first
+			std::vector<Entity> remapped = dst.CreateEntities(entities.size());  // Allocate all of the destination entities at once
+
+			for(size_t id = 0; id < storages.size(); id++) {  // For each storage...
+				auto& src = storages[id];
+				if(src.elementSize == std::numeric_limits<size_t>::max()) continue;  // Skip storages that were never used
+
+				Storage* out = nullptr;  // Only create the destination storage if something actually moves into it
+				for(size_t i = 0; i < entities.size(); i++) {  // ... copy over the component of every migrating entity that has one
+					auto& mask = entityMasks[entities[i]];
+					if(mask.size() <= id || !mask[id]) continue;
+					if(!out) out = &dst.GetStorage(id, src.elementSize);
+					std::memcpy(out->GetOrAllocateRaw(remapped[i]), src.GetRaw(entities[i]), src.elementSize);
+				}
+			}
+
+			for(size_t i = 0; i < entities.size(); i++) {  // Hand the masks over and empty out the source entities
+				auto& mask = entityMasks[entities[i]];
+				for(size_t id = 0; id < mask.size(); id++)
+					if(mask[id]) {
+						ListEntity(entities[i], id, false);
+						dst.ListEntity(remapped[i], id, true);
+					}
+				dst.entityMasks[remapped[i]] = std::move(mask);
+				entityMasks[entities[i]] = std::vector<bool>{false};
+			}
+			return remapped;
+		}
+
 		template<typename Tcomponent>  // Add a component to an entity
-		Tcomponent& AddComponent(Entity e) {
-			size_t id = GetComponentID<Tcomponent>();  // Get component ID
-			auto& eMask = entityMasks[e];  // Get the entity's mask
-			if(eMask.size() <= id)  // If the mask is too small, resize it
-				eMask.resize(id + 1, false);
-			eMask[id] = true;  // Set the component bit in the mask
-			return GetStorage<Tcomponent>().template GetOrAllocate<Tcomponent>(e);  // Return the component
+		ComponentReference<Tcomponent> AddComponent(Entity e) {
+			if constexpr(SplitComponentType<Tcomponent>) {
+				bool existed = HasComponent<Tcomponent>(e);
+				SetMask(e, GetComponentID<Tcomponent>(), true);  // Set the component bit in the mask
+				return [&]<size_t... I>(std::index_sequence<I...>) {
+					Tcomponent initial{};  // New columns are seeded with the component's default field values
+					return SplitView<Tcomponent>{{&AddField<std::get<I>(SplitComponent<Tcomponent>::fields)>(e, initial, existed)...}};
+				}(SplitFieldIndices<Tcomponent>{});
+			} else {
+				SetMask(e, GetComponentID<Tcomponent>(), true);  // Set the component bit in the mask
+				return GetStorage<Tcomponent>().template GetOrAllocate<Tcomponent>(e);  // Return the component
+			}
 		}
 
 		template<typename Tcomponent>  // Remove a component from an entity
 		void RemoveComponent(Entity e) {
-			size_t id = GetComponentID<Tcomponent>();  // Get component ID
-			auto& eMask = entityMasks[e];  // Get the entity's mask
-			if(eMask.size() > id)  // If the component exists, remove it from the mask
-				eMask[id] = false;
+			SetMask(e, GetComponentID<Tcomponent>(), false);  // If the component exists, remove it from the mask
+			if constexpr(SplitComponentType<Tcomponent>)  // Split components also need their columns cleared
+				[&]<size_t... I>(std::index_sequence<I...>) {
+					(SetMask(e, FieldID<std::get<I>(SplitComponent<Tcomponent>::fields)>(), false), ...);
+				}(SplitFieldIndices<Tcomponent>{});
 		}
 
 		template<typename Tcomponent>  // Get a component from an entity
-		Tcomponent& GetComponent(Entity e) {
+		ComponentReference<Tcomponent> GetComponent(Entity e) {
 			size_t id = GetComponentID<Tcomponent>();  // Get component ID
 			assert(entityMasks[e][id]);  // Ensure the component exists on the entity
-			return GetStorage<Tcomponent>().template Get<Tcomponent>(e);  // Return the component
+			if constexpr(SplitComponentType<Tcomponent>)
+				return [&]<size_t... I>(std::index_sequence<I...>) {
+					return SplitView<Tcomponent>{{&GetField<std::get<I>(SplitComponent<Tcomponent>::fields)>(e)...}};
+				}(SplitFieldIndices<Tcomponent>{});
+			else return GetStorage<Tcomponent>().template Get<Tcomponent>(e);  // Return the component
+		}
+
+		template<auto Field>  // Get the column storing a single field of a split component
+		Storage& GetFieldStorage() {
+			return GetStorage(FieldID<Field>(), sizeof(typename FieldTraits<decltype(Field)>::Type));
+		}
+
+		template<auto Field>  // Get a single field of a split component without touching its other columns
+		typename FieldTraits<decltype(Field)>::Type& GetField(Entity e) {
+			return GetFieldStorage<Field>().template Get<typename FieldTraits<decltype(Field)>::Type>(e);
 		}
 
 		template<typename Tcomponent>  // Check if an entity has a specific component
@@ -118,6 +349,112 @@ namespace cs381 {
 			size_t id = GetComponentID<Tcomponent>();  // Get component ID
 			return entityMasks[e].size() > id && entityMasks[e][id];  // Check if component bit is set in the mask
 		}
+
+		template<typename... Tcomponents>  // View over every entity which has all of the given components
+		BasicSceneView<Storage, Tcomponents...> View() { return {*this}; }
+
+		// Double buffering: while a tick runs, systems read the normal storages and write to a back buffer of them,
+		// so systems can run in parallel without locks or ordering. BeginWrite starts the back buffer as a copy of the
+		// current state (so fields nobody writes keep their value) and SwapBuffers publishes it
+		// Both must be called on the main thread while no system is running, edits made between ticks are kept
+		// Cost: BeginWrite copies every buffered storage whole (every entity's slot) each tick, whether or not anything
+		// writes it, so buffer only what the tick writes, BeginWriteFields buffers single columns of split components
+		template<typename... Tcomponents>  // Start a tick's back buffers for the given components (split components buffer every column)
+		void BeginWrite() { (ForEachStorageID<Tcomponents>([this](size_t id) { BeginWrite(id); }), ...); }
+
+		template<auto... Fields>  // Start a tick's back buffers for just the given columns of split components
+		void BeginWriteFields() { (BeginWrite(FieldID<Fields>()), ...); }
+
+		void BeginWrite(size_t id) {
+			assert(id < storages.size() && storages[id].elementSize != std::numeric_limits<size_t>::max());  // Only storages which exist can be buffered
+			if(writeStorages.size() <= id) {
+				writeStorages.resize(id + 1, Storage());
+				buffering.resize(id + 1, false);
+			}
+			writeStorages[id] = storages[id];  // Copy assignment reuses the back buffer's memory once it is big enough
+			buffering[id] = true;
+		}
+
+		template<typename... Tcomponents>  // Publish the back buffers of the given components
+		void SwapBuffers() { (ForEachStorageID<Tcomponents>([this](size_t id) { SwapBuffers(id); }), ...); }
+
+		template<auto... Fields>  // Publish the back buffers of the given columns
+		void SwapFieldBuffers() { (SwapBuffers(FieldID<Fields>()), ...); }
+
+		void SwapBuffers(size_t id) {
+			assert(IsBuffering(id));  // BeginWrite must have been called first
+			std::swap(storages[id], writeStorages[id]);
+			buffering[id] = false;
+		}
+
+		bool IsBuffering(size_t id) const { return id < buffering.size() && buffering[id]; }  // Has a back buffer been started (and not yet published)
+		bool IsBuffering() const { return std::find(buffering.begin(), buffering.end(), true) != buffering.end(); }  // Is any back buffer started
+
+		template<typename Tcomponent>  // Get the back buffer of a component's storage
+		Storage& GetWriteStorage() {
+			static_assert(!SplitComponentType<Tcomponent>, "Split components are buffered column by column, use GetWriteFieldStorage");
+			assert(IsBuffering(GetComponentID<Tcomponent>()));  // BeginWrite must have been called first
+			return writeStorages[GetComponentID<Tcomponent>()];
+		}
+
+		template<typename Tcomponent>  // Get the copy of an entity's component which will be published by the next SwapBuffers
+		Tcomponent& WriteComponent(Entity e) {
+			assert(HasComponent<Tcomponent>(e));  // Ensure the component exists on the entity
+			return GetWriteStorage<Tcomponent>().template Get<Tcomponent>(e);
+		}
+
+		template<auto Field>  // Get the back buffer of a split component's column
+		Storage& GetWriteFieldStorage() {
+			assert(IsBuffering(FieldID<Field>()));  // BeginWrite(Fields) must have been called for this column
+			return writeStorages[FieldID<Field>()];
+		}
+
+		template<auto Field>  // Get the copy of a single field which will be published by the next SwapBuffers
+		typename FieldTraits<decltype(Field)>::Type& WriteField(Entity e) {
+			return GetWriteFieldStorage<Field>().template Get<typename FieldTraits<decltype(Field)>::Type>(e);
+		}
+
+	protected:
+		void SetMask(Entity e, size_t id, bool value) {  // Set or clear a component bit in an entity's mask
+			auto& eMask = entityMasks[e];  // Get the entity's mask
+			if(eMask.size() <= id) {  // If the mask is too small, resize it
+				if(!value) return;
+				eMask.resize(id + 1, false);
+			}
+			if(eMask[id] == value) return;
+			eMask[id] = value;
+			ListEntity(e, id, value);
+		}
+
+		void ListEntity(Entity e, size_t id, bool value) {  // Add or remove an entity in a component's entity list, keeping it sorted
+			if(componentEntities.size() <= id)
+				componentEntities.resize(id + 1);
+			auto& list = componentEntities[id];
+			if(value && (list.empty() || list.back() < e)) list.push_back(e);  // Components are mostly added in creation order
+			else if(value) list.insert(std::lower_bound(list.begin(), list.end(), e), e);
+			else list.erase(std::lower_bound(list.begin(), list.end(), e));
+		}
+
+		template<auto Field>  // Component ID of a field column
+		static size_t FieldID() { return GetComponentID<FieldTag<Field>>(); }
+
+		template<typename Tcomponent, typename F>  // Call f with the ID of every storage holding Tcomponent's data
+		static void ForEachStorageID(F&& f) {
+			if constexpr(SplitComponentType<Tcomponent>)
+				[&]<size_t... I>(std::index_sequence<I...>) {
+					(f(FieldID<std::get<I>(SplitComponent<Tcomponent>::fields)>()), ...);
+				}(SplitFieldIndices<Tcomponent>{});
+			else f(GetComponentID<Tcomponent>());
+		}
+
+		template<auto Field>  // Allocate (and seed) a split component's column for an entity, field columns get their own mask bits so migration picks them up
+		typename FieldTraits<decltype(Field)>::Type& AddField(Entity e, const typename FieldTraits<decltype(Field)>::Component& initial, bool existed) {
+			using Type = typename FieldTraits<decltype(Field)>::Type;
+			SetMask(e, FieldID<Field>(), true);
+			std::byte* slot = GetFieldStorage<Field>().GetOrAllocateRaw(e);
+			if(!existed) return *new(slot) Type(initial.*Field);
+			return *(Type*)slot;
+		}
 	};
 
 	// SkiplistComponentStorage is an alternative storage for components that uses a skiplist for indexing
@@ -166,48 +503,92 @@ namespace cs381 {
 				return Allocate<Tcomponent>(e);
 			return Get<Tcomponent>(e);  // Return the existing component
 		}
+
+		std::byte* GetRaw(Entity e) {  // Untyped access to an entity's component bytes
+			assert(e < indecies.size());  // Ensure entity index is within bounds
+			assert(indecies[e] != std::numeric_limits<size_t>::max());  // Ensure index is valid
+			return data.data() + indecies[e];
+		}
+
+		std::byte* GetOrAllocateRaw(Entity e) {  // Untyped get or allocate, new slots are zero filled
+			if (indecies.size() <= e)  // If entity index is out of bounds, allocate more
+				indecies.resize(size_t(e) + 1, -1);
+			if (indecies[e] == std::numeric_limits<size_t>::max()) {  // If component not allocated, append a slot for it
+				indecies[e] = data.size();
+				data.insert(data.end(), elementSize, std::byte{0});
+			}
+			return GetRaw(e);
+		}
 	};
 
 	using post_increment_t = int;  // Alias for post-increment type used in iterators
 
 	// SceneView is a view into the scene for iterating over entities with specific components
-	template<typename... Tcomponents>  // Template for multiple component types
-	struct SceneView {
-		Scene<SkiplistComponentStorage>& scene;  // Reference to the scene
+	// Only the entities which have the view's rarest component are visited (from the scene's per component lists, in
+	// ascending order), each is then checked for the rest, so entities without the components cost nothing
+	template<typename Storage, typename... Tcomponents>  // Template for the scene's storage and multiple component types
+	struct BasicSceneView {
+		Scene<Storage>& scene;  // Reference to the scene
 
 		struct Sentinel {};  // Sentinel type to mark the end of an iterator
 		struct Iterator {  // Iterator type for iterating over entities
-			Scene<SkiplistComponentStorage>* scene = nullptr;  // Pointer to the scene
-			Entity e;  // Current entity
+			Scene<Storage>* scene = nullptr;  // Pointer to the scene
+			const std::vector<Entity>* candidates = nullptr;  // Entities with the rarest of the components
+			size_t index = 0;  // Current position in candidates
 
-			bool valid() { return (scene->HasComponent<Tcomponents>(e) && ...); }  // Check if entity has all required components
+			bool valid() { return (scene->template HasComponent<Tcomponents>(entity()) && ...); }  // Check if entity has all required components
 
-			bool operator==(Sentinel) { return scene == nullptr || e >= scene->entityMasks.size(); }  // Check if iterator reached the end
+			bool operator==(Sentinel) { return candidates == nullptr || index >= candidates->size(); }  // Check if iterator reached the end
 
-			Iterator& operator++(post_increment_t) {  // Post-increment operator for iterator
+			Iterator& operator++() {  // Pre-increment operator for iterator
 				do {
-					e++;  // Move to the next entity
-				} while(!valid() && e < scene->entityMasks.size());  // Skip invalid entities
+					index++;  // Move to the next candidate
+				} while(index < candidates->size() && !valid());  // Skip candidates missing other components (checking the bounds first)
 				return *this;
 			}
 
-			Iterator operator++() {  // Pre-increment operator for iterator
-				Iterator old;
-				operator++(0);  // Call post-increment
+			Iterator operator++(post_increment_t) {  // Post-increment operator for iterator
+				Iterator old = *this;
+				++*this;
 				return old;  // Return the old iterator
 			}
 
+			Entity entity() const { return (*candidates)[index]; }  // The entity the iterator is on
+
 			// std::tuple<std::add_lvalue_reference_t<Tcomponents>...> operator*() { return { scene->GetComponent<Tcomponents>(e)... }; }  // Access components of entity
-			std::tuple<std::add_lvalue_reference_t<Tcomponents>...> operator*() { return { scene->GetComponent<Tcomponents>(e)... }; }  // Dereference iterator to get components
+			std::tuple<ComponentReference<Tcomponents>...> operator*() { return { scene->template GetComponent<Tcomponents>(entity())... }; }  // Dereference iterator to get components (split components come back as a SplitView)
 		};
 
 		Iterator begin() {  // Get the iterator for the beginning of the view
-			Iterator out{&scene, 0};  // Create iterator starting at entity 0
-			if(!out.valid()) ++out;  // Skip invalid entities
+			static const std::vector<Entity> none;
+			const std::vector<Entity>* rarest = nullptr;
+			for(size_t id : {GetComponentID<Tcomponents>()...}) {  // Pick the shortest entity list
+				const std::vector<Entity>& list = id < scene.componentEntities.size() ? scene.componentEntities[id] : none;
+				if(!rarest || list.size() < rarest->size()) rarest = &list;
+			}
+			Iterator out{&scene, rarest, 0};  // Create iterator starting at the first candidate
+			if(out != Sentinel{} && !out.valid()) ++out;  // Skip invalid entities
 			return out;  // Return iterator
 		}
 		Sentinel end() { return {}; }  // Return the sentinel for the end of the view
+
+		std::vector<std::pair<Entity, Entity>> Runs() {  // Ranges [first, last) of consecutive matching entities, lets batch kernels work on whole column slices
+			std::vector<std::pair<Entity, Entity>> runs;
+			for(auto it = begin(); it != end(); ++it)
+				if(!runs.empty() && runs.back().second == it.entity()) runs.back().second++;
+				else runs.push_back({it.entity(), it.entity() + 1});
+			return runs;
+		}
+
+		template<typename F>  // Call f(entity, components...) for every matching entity
+		void ForEach(F&& f) {
+			for(auto it = begin(); it != end(); ++it)
+				std::apply([&](auto&&... components) { f(it.entity(), std::forward<decltype(components)>(components)...); }, *it);
+		}
 	};
+
+	template<typename... Tcomponents>  // View into the default skiplist backed scene
+	using SceneView = BasicSceneView<SkiplistComponentStorage, Tcomponents...>;
 }
 
 #endif // ECS_HPP
@@ -0,0 +1,78 @@
+#ifndef FRAME_WORKER_POOL_HPP
+#define FRAME_WORKER_POOL_HPP
+
+#include <atomic>
+#include <barrier>
+#include <functional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Profiler.hpp"
+
+namespace cs381 {
+
+	// FrameWorkerPool keeps its threads alive for the whole program and wakes them once per Run
+	// Workers park on a std::barrier (a futex wait, no busy spinning) between runs, so a frame costs two barrier
+	// phases instead of creating and joining a thread per system
+	// Tasks must be pure simulation work, anything touching raylib (input, drawing, audio) stays on the main thread
+	struct FrameWorkerPool {
+		using Task = std::function<void()>;
+
+		FrameWorkerPool(size_t workerCount = DefaultWorkerCount()) : sync(workerCount + 1) {  // The calling thread is the extra participant
+			workers.reserve(workerCount);
+			for(size_t i = 0; i < workerCount; i++)
+				workers.emplace_back([this, i] {
+					Profiler::Instance().SetThreadName("Worker " + std::to_string(i + 1));  // Each worker gets its own lane in profiles
+					WorkerLoop();
+				});
+		}
+		FrameWorkerPool(const FrameWorkerPool&) = delete;
+		FrameWorkerPool& operator=(const FrameWorkerPool&) = delete;
+
+		~FrameWorkerPool() {
+			stopping = true;
+			sync.arrive_and_wait();  // Release the workers so they can see that we are stopping
+			for(auto& worker: workers)
+				worker.join();
+		}
+
+		void Run(std::span<const Task> frameTasks) {  // Run every task (on the workers and the calling thread), returns once all have finished
+			tasks = frameTasks;
+			nextTask.store(0, std::memory_order_relaxed);
+			sync.arrive_and_wait();  // Start barrier: workers wake up and see the new tasks
+			Work();
+			sync.arrive_and_wait();  // End barrier: every task is done and nobody touches tasks anymore
+		}
+
+		size_t WorkerCount() const { return workers.size(); }
+
+		static size_t DefaultWorkerCount() {  // Leave one hardware thread for the main thread
+			unsigned hardware = std::thread::hardware_concurrency();
+			return hardware > 1 ? hardware - 1 : 1;
+		}
+
+	private:
+		std::vector<std::thread> workers;
+		std::barrier<> sync;  // Used twice per run, once to start and once to finish
+		std::span<const Task> tasks;  // Only read between the two barriers of a run
+		std::atomic<size_t> nextTask = 0;  // Index of the next unclaimed task
+		bool stopping = false;  // Written before a barrier, read after it
+
+		void Work() {  // Claim and run tasks until there are none left
+			for(size_t i = nextTask.fetch_add(1, std::memory_order_relaxed); i < tasks.size(); i = nextTask.fetch_add(1, std::memory_order_relaxed))
+				tasks[i]();
+		}
+
+		void WorkerLoop() {
+			while(true) {
+				sync.arrive_and_wait();  // Sleep until the next run (or shutdown)
+				if(stopping) return;
+				Work();
+				sync.arrive_and_wait();
+			}
+		}
+	};
+}
+
+#endif // FRAME_WORKER_POOL_HPP
@@ -0,0 +1,130 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+
+namespace cs381 {
+
+	thread_local Profiler::ThreadLog* Profiler::localLog = nullptr;
+
+	Profiler::ThreadLog& Profiler::LocalLog() {
+		if (localLog) return *localLog;
+		std::lock_guard lock(threadsMutex);
+		logs.push_back(std::make_unique<ThreadLog>());
+		localLog = logs.back().get();
+		localLog->index = logs.size() - 1;
+		threadNames.push_back("Thread " + std::to_string(localLog->index));
+		return *localLog;
+	}
+
+	void Profiler::SetThreadName(std::string name) {
+		ThreadLog& log = LocalLog();
+		std::lock_guard lock(threadsMutex);
+		threadNames[log.index] = std::move(name);
+	}
+
+	void Profiler::SetEnabled(bool enable) {
+		enabled.store(enable, std::memory_order_relaxed);
+		if (enable) return;
+		count = 0;
+		std::lock_guard lock(threadsMutex);
+		for (auto& log : logs) log->zones.clear();
+	}
+
+	void Profiler::BeginFrame() {
+		frameStart = Now();
+	}
+
+	void Profiler::EndFrame() {
+		if (!Enabled()) return;
+
+		Frame& frame = frames[head];
+		frame.start = frameStart;
+		frame.end = Now();
+		frame.zones.clear();
+		{
+			std::lock_guard lock(threadsMutex);
+			for (auto& log : logs) {
+				frame.zones.insert(frame.zones.end(), log->zones.begin(), log->zones.end());
+				log->zones.clear();  // Keeps its capacity, so steady state frames don't allocate
+			}
+		}
+
+		head = (head + 1) % FrameCapacity;
+		count = std::min(count + 1, FrameCapacity);
+	}
+
+	std::vector<Profiler::ZoneStats> Profiler::Summary() const {
+		struct Totals { uint16_t depth; float sum = 0, max = 0, frame = 0; };
+		std::vector<const char*> order;  // First seen order, which roughly follows the frame
+		std::unordered_map<const char*, Totals> totals;
+
+		for (size_t i = 0; i < count; ++i) {
+			const Frame& frame = GetFrame(i);
+			for (auto& zone : frame.zones) {
+				auto [it, inserted] = totals.try_emplace(zone.name, Totals{ zone.depth });
+				if (inserted) order.push_back(zone.name);
+				it->second.depth = std::min(it->second.depth, zone.depth);
+				it->second.frame += (zone.end - zone.start) / 1e6f;
+			}
+			for (auto& [name, total] : totals) {
+				total.sum += total.frame;
+				total.max = std::max(total.max, total.frame);
+				total.frame = 0;
+			}
+		}
+
+		std::vector<ZoneStats> stats;
+		stats.reserve(order.size());
+		for (const char* name : order) {
+			const Totals& total = totals[name];
+			stats.push_back({ name, total.depth, total.sum / count, total.max });
+		}
+		return stats;
+	}
+
+	static void WriteJSONString(std::ostream& out, const std::string& string) {
+		out << '"';
+		for (char c : string) {
+			if (c == '"' || c == '\\') out << '\\';
+			if ((unsigned char)c >= 0x20) out << c;
+		}
+		out << '"';
+	}
+
+	bool Profiler::ExportChromeTrace(const std::string& path) const {
+		std::ofstream out(path);
+		if (!out) return false;
+		out.precision(3);
+		out << std::fixed << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		// One lane per thread, named after SetThreadName
+		std::vector<std::string> names;
+		{
+			std::lock_guard lock(threadsMutex);
+			names = threadNames;
+		}
+		for (size_t i = 0; i < names.size(); ++i) {
+			out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << i << ",\"args\":{\"name\":";
+			WriteJSONString(out, names[i]);
+			out << "}},\n";
+			out << "{\"ph\":\"M\",\"name\":\"thread_sort_index\",\"pid\":0,\"tid\":" << i << ",\"args\":{\"sort_index\":" << i << "}},\n";
+		}
+
+		// Complete ("X") events, timestamps in microseconds. Frames get their own lane above the threads
+		uint64_t frameLane = names.size();
+		out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << frameLane << ",\"args\":{\"name\":\"Frames\"}},\n";
+		out << "{\"ph\":\"M\",\"name\":\"thread_sort_index\",\"pid\":0,\"tid\":" << frameLane << ",\"args\":{\"sort_index\":-1}}";
+		for (size_t i = 0; i < count; ++i) {
+			const Frame& frame = GetFrame(i);
+			out << ",\n{\"ph\":\"X\",\"name\":\"Frame\",\"pid\":0,\"tid\":" << frameLane << ",\"ts\":" << frame.start / 1e3 << ",\"dur\":" << (frame.end - frame.start) / 1e3 << '}';
+			for (auto& zone : frame.zones) {
+				out << ",\n{\"ph\":\"X\",\"name\":";
+				WriteJSONString(out, zone.name);
+				out << ",\"pid\":0,\"tid\":" << zone.thread << ",\"ts\":" << zone.start / 1e3 << ",\"dur\":" << (zone.end - zone.start) / 1e3 << '}';
+			}
+		}
+		out << "\n]}\n";
+		return bool(out);
+	}
+}
@@ -0,0 +1,129 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped profiling zones: CS381_PROFILE_ZONE("Name") times from that line to the end of the enclosing scope
+// Names must be string literals (only the pointer is kept). Define CS381_PROFILING=0 to compile every zone away,
+// otherwise a zone costs one relaxed atomic load while the profiler is disabled
+#ifndef CS381_PROFILING
+#define CS381_PROFILING 1
+#endif
+
+#define CS381_PROFILE_CONCAT_IMPL(a, b) a##b
+#define CS381_PROFILE_CONCAT(a, b) CS381_PROFILE_CONCAT_IMPL(a, b)
+#if CS381_PROFILING
+#define CS381_PROFILE_ZONE(name) cs381::ProfileZone CS381_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define CS381_PROFILE_ZONE(name) (void)0
+#endif
+
+namespace cs381 {
+
+	// The profiler keeps the zones of the last FrameCapacity frames in a ring buffer
+	// Every thread appends to its own log (no locking), EndFrame then moves all the logs into the frame's slot
+	// EndFrame must be called while no other thread is inside a zone, which the FrameWorkerPool guarantees between Runs
+	struct Profiler {
+		using Clock = std::chrono::steady_clock;
+
+		struct Zone {
+			const char* name;
+			int64_t start, end;  // Nanoseconds since the profiler was created
+			uint16_t thread;  // Index into threadNames
+			uint16_t depth;  // How many zones this one is nested in (on its thread)
+		};
+
+		struct Frame {
+			int64_t start = 0, end = 0;
+			std::vector<Zone> zones;
+
+			float Milliseconds() const { return (end - start) / 1e6f; }
+		};
+
+		struct ZoneStats {  // A zone's time averaged over the buffered frames (a zone running several times a frame is summed first)
+			const char* name;
+			uint16_t depth;  // Shallowest depth the zone was seen at
+			float averageMs, maxMs;
+		};
+
+		static constexpr size_t FrameCapacity = 240;
+
+		static Profiler& Instance() {
+			static Profiler instance;
+			return instance;
+		}
+
+		bool Enabled() const { return enabled.load(std::memory_order_relaxed); }
+		void SetEnabled(bool enable);  // Disabling drops the buffered frames
+
+		void SetThreadName(std::string name);  // Label for the calling thread's lane in the overlay and trace
+
+		void BeginFrame();
+		void EndFrame();
+
+		// Buffered frames, oldest first (index 0) to newest
+		size_t FrameCount() const { return count; }
+		const Frame& GetFrame(size_t i) const { return frames[(head + FrameCapacity - count + i) % FrameCapacity]; }
+
+		std::vector<ZoneStats> Summary() const;
+		bool ExportChromeTrace(const std::string& path) const;  // Writes the buffered frames as Chrome trace JSON (chrome://tracing or ui.perfetto.dev)
+
+		int64_t Now() const { return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count(); }
+
+	protected:
+		friend struct ProfileZone;
+
+		struct ThreadLog {
+			uint16_t index;
+			uint16_t depth = 0;
+			std::vector<Zone> zones;  // Only touched by the owning thread, or by EndFrame while the thread is outside any zone
+		};
+
+		std::atomic<bool> enabled = false;
+		Clock::time_point epoch = Clock::now();
+
+		mutable std::mutex threadsMutex;  // Guards logs and threadNames, only taken the first time a thread records something
+		std::vector<std::unique_ptr<ThreadLog>> logs;
+		std::vector<std::string> threadNames;
+
+		Frame frames[FrameCapacity];
+		size_t head = 0;  // Slot the next frame is written to
+		size_t count = 0;
+		int64_t frameStart = 0;
+
+		static thread_local ThreadLog* localLog;  // The calling thread's log, created on its first zone
+		ThreadLog& LocalLog();
+	};
+
+	struct ProfileZone {
+		explicit ProfileZone(const char* name) {
+			Profiler& profiler = Profiler::Instance();
+			if (!profiler.Enabled()) return;
+			log = &profiler.LocalLog();
+			this->name = name;
+			depth = log->depth++;
+			start = profiler.Now();
+		}
+		~ProfileZone() {
+			if (!log) return;
+			log->depth--;
+			log->zones.push_back({ name, start, Profiler::Instance().Now(), log->index, depth });
+		}
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	protected:
+		Profiler::ThreadLog* log = nullptr;
+		const char* name;
+		int64_t start;
+		uint16_t depth;
+	};
+}
+
+#endif // PROFILER_HPP
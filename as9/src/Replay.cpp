@@ -0,0 +1,83 @@
+#include "Replay.hpp"
+#include <bit>
+#include <cstring>
+
+namespace cs381 {
+
+    static constexpr char Magic[4] = { 'C', 'N', 'R', 'P' };
+    static constexpr uint16_t Version = 1;
+
+    enum InputBits : uint8_t {
+        Accelerate = 1 << 0,
+        Decelerate = 1 << 1,
+        TurnLeft = 1 << 2,
+        TurnRight = 1 << 3,
+        SelectNext = 1 << 4,
+    };
+
+    // Integers are written a byte at a time (lowest first) so files work across machines
+    template<typename T>
+    static void Write(std::ostream& out, T value) {
+        uint64_t bits;
+        if constexpr (std::is_floating_point_v<T>) bits = std::bit_cast<uint32_t>(value);
+        else bits = value;
+        for (size_t i = 0; i < sizeof(T); ++i) out.put(char((bits >> (8 * i)) & 0xFF));
+    }
+
+    template<typename T>
+    static bool Read(std::istream& in, T& value) {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            int byte = in.get();
+            if (byte == EOF) return false;
+            bits |= uint64_t(byte) << (8 * i);
+        }
+        if constexpr (std::is_floating_point_v<T>) value = std::bit_cast<float>(uint32_t(bits));
+        else value = T(bits);
+        return true;
+    }
+
+    static uint8_t Pack(const InputSnapshot& input) {
+        return (input.accelerate ? Accelerate : 0) | (input.decelerate ? Decelerate : 0) | (input.turnLeft ? TurnLeft : 0)
+            | (input.turnRight ? TurnRight : 0) | (input.selectNext ? SelectNext : 0);
+    }
+
+    static InputSnapshot Unpack(uint8_t bits) {
+        return { bool(bits & Accelerate), bool(bits & Decelerate), bool(bits & TurnLeft), bool(bits & TurnRight), bool(bits & SelectNext) };
+    }
+
+    bool InputRecorder::Open(const std::string& path, const ReplayHeader& header) {
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(Magic, sizeof(Magic));
+        Write(file, Version);
+        Write(file, header.seed);
+        Write(file, header.cars);
+        Write(file, header.tickRate);
+        return bool(file);
+    }
+
+    void InputRecorder::Record(float frameTime, const InputSnapshot& input) {
+        if (!file.is_open()) return;
+        Write(file, frameTime);
+        Write(file, Pack(input));
+    }
+
+    bool InputReplay::Load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        char magic[4];
+        uint16_t version;
+        if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, Magic, sizeof(Magic)) != 0) return false;
+        if (!Read(file, version) || version != Version) return false;
+        if (!Read(file, header.seed) || !Read(file, header.cars) || !Read(file, header.tickRate)) return false;
+
+        frames.clear();
+        next = 0;
+        float frameTime;
+        uint8_t bits;
+        while (Read(file, frameTime) && Read(file, bits)) {  // A truncated last frame (crash while recording) is dropped
+            frames.push_back({ frameTime, Unpack(bits) });
+        }
+        return true;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+// Recording and replaying Conenado sessions
+// Everything the simulation consumes is recorded: the setup (RNG seed and car count) once, then every frame's length
+// and input snapshot (5 bytes a frame). Feeding those back through Simulation::Frame reproduces the session exactly,
+// no matter how fast the replay is played or whether it is drawn at all
+//
+// File layout (little endian): "CNRP", u16 version, u64 seed, u32 cars, f32 tick rate, then until the end of the
+// file one f32 frame time and one u8 of input bits per frame
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Simulation.hpp"
+
+namespace cs381 {
+
+    struct ReplayHeader {
+        uint64_t seed = 0;
+        uint32_t cars = 1;
+        float tickRate = 60;
+    };
+
+    struct ReplayFrame {
+        float frameTime;
+        InputSnapshot input;
+    };
+
+    struct InputRecorder {
+        bool Open(const std::string& path, const ReplayHeader& header);  // Returns false if the file can't be written
+        void Record(float frameTime, const InputSnapshot& input);  // Does nothing unless open
+        bool IsOpen() const { return file.is_open(); }
+
+    protected:
+        std::ofstream file;
+    };
+
+    struct InputReplay {
+        ReplayHeader header;
+        std::vector<ReplayFrame> frames;
+        size_t next = 0;  // Index of the next frame to play
+
+        bool Load(const std::string& path);  // Returns false if the file is missing or isn't a replay
+
+        bool Done() const { return next >= frames.size(); }
+        const ReplayFrame& Peek() const { return frames[next]; }
+        const ReplayFrame& Next() { return frames[next++]; }
+    };
+}
+
+#endif // REPLAY_HPP
@@ -0,0 +1,261 @@
+#include "SimdKernels.hpp"
+
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+	#define CS381_SIMD_AVX2
+	#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+	#define CS381_SIMD_NEON
+	#include <arm_neon.h>
+#endif
+
+// This file must be built with -ffp-contract=off (see CMakeLists.txt) so the compiler never fuses the scalar
+// path's multiplies and adds, which would make it round differently from the vector paths
+
+namespace cs381::simd {
+
+	namespace {
+		// Cephes sinf/cosf constants
+		constexpr float FourOverPi = 1.27323954473516f;
+		constexpr float DP1 = 0.78515625f, DP2 = 2.4187564849853515625e-4f, DP3 = 3.77489497744594108e-8f;  // pi/4 split in three for exact reduction
+		constexpr float S0 = -1.9515295891e-4f, S1 = 8.3321608736e-3f, S2 = -1.6666654611e-1f;
+		constexpr float C0 = 2.443315711809948e-5f, C1 = -1.388731625493765e-3f, C2 = 4.166664568298827e-2f;
+		constexpr float DegreesToRadians = 3.14159265358979323846f / 180.0f;
+		constexpr float InverseFullTurn = 1.0f / 360.0f;
+		constexpr uint32_t SignBit = 0x80000000;
+
+		// Scalar versions, also used for the leftover elements of the vector versions
+
+		void SinCosOne(float x, float& sine, float& cosine) {
+			uint32_t signSin = std::bit_cast<uint32_t>(x) & SignBit;
+			x = std::fabs(x);
+			int32_t j = (int32_t)(x * FourOverPi);  // Octant
+			j = (j + 1) & ~1;  // Round up to an even octant
+			float y = (float)j;
+			uint32_t swapSin = uint32_t(j & 4) << 29;
+			uint32_t signCos = uint32_t(~(j - 2) & 4) << 29;
+			bool sinPolynomial = (j & 2) == 0;  // Octants 2 and 6 swap the sine and cosine polynomials
+
+			x = ((x - y * DP1) - y * DP2) - y * DP3;  // x is now in [-pi/4, pi/4]
+			float z = x * x;
+			float cosPoly = (((C0 * z + C1) * z + C2) * z * z - z * 0.5f) + 1.0f;
+			float sinPoly = ((S0 * z + S1) * z + S2) * z * x + x;
+
+			sine = std::bit_cast<float>(std::bit_cast<uint32_t>(sinPolynomial ? sinPoly : cosPoly) ^ (signSin ^ swapSin));
+			cosine = std::bit_cast<float>(std::bit_cast<uint32_t>(sinPolynomial ? cosPoly : sinPoly) ^ signCos);
+		}
+
+		float WrapDegrees(float degrees) { return degrees - 360.0f * std::nearbyint(degrees * InverseFullTurn); }  // To [-180, 180]
+
+		void HeadingToVelocityOne(float heading, float speed, float* velocity) {
+			float sine, cosine;
+			SinCosOne(WrapDegrees(heading) * DegreesToRadians, sine, cosine);
+			velocity[0] = cosine * speed;
+			velocity[1] = 0;
+			velocity[2] = -(sine * speed);
+		}
+
+		void SinCosScalar(std::span<const float> radians, std::span<float> sines, std::span<float> cosines) {
+			assert(sines.size() >= radians.size() && cosines.size() >= radians.size());
+			for(size_t i = 0; i < radians.size(); i++)
+				SinCosOne(radians[i], sines[i], cosines[i]);
+		}
+
+		void HeadingToVelocityScalar(std::span<const float> headingDegrees, std::span<const float> speeds, std::span<float> velocities) {
+			assert(speeds.size() >= headingDegrees.size() && velocities.size() >= headingDegrees.size() * 3);
+			for(size_t i = 0; i < headingDegrees.size(); i++)
+				HeadingToVelocityOne(headingDegrees[i], speeds[i], velocities.data() + i * 3);
+		}
+
+		void IntegrateScalar(std::span<float> out, std::span<const float> positions, std::span<const float> velocities, float dt) {
+			assert(out.size() >= positions.size() && velocities.size() >= positions.size());
+			for(size_t i = 0; i < positions.size(); i++)
+				out[i] = positions[i] + velocities[i] * dt;
+		}
+
+		const Kernels scalarKernels = {"scalar", SinCosScalar, HeadingToVelocityScalar, IntegrateScalar};
+
+#ifdef CS381_SIMD_AVX2
+		#define CS381_AVX2 __attribute__((target("avx2")))
+
+		CS381_AVX2 inline void SinCos8(__m256 x, __m256& sine, __m256& cosine) {
+			const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(SignBit));
+			const __m256i two = _mm256_set1_epi32(2), four = _mm256_set1_epi32(4);
+
+			__m256 signSin = _mm256_and_ps(x, signMask);
+			x = _mm256_andnot_ps(signMask, x);
+			__m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(FourOverPi)));
+			j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+			__m256 y = _mm256_cvtepi32_ps(j);
+			__m256 swapSin = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, four), 29));
+			__m256 signCos = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(j, two), four), 29));
+			__m256 sinPolynomial = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, two), _mm256_setzero_si256()));
+
+			x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP1)));
+			x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP2)));
+			x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP3)));
+			__m256 z = _mm256_mul_ps(x, x);
+
+			__m256 cosPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(C0), z), _mm256_set1_ps(C1));
+			cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, z), _mm256_set1_ps(C2));
+			cosPoly = _mm256_mul_ps(_mm256_mul_ps(cosPoly, z), z);
+			cosPoly = _mm256_sub_ps(cosPoly, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+			cosPoly = _mm256_add_ps(cosPoly, _mm256_set1_ps(1.0f));
+
+			__m256 sinPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(S0), z), _mm256_set1_ps(S1));
+			sinPoly = _mm256_add_ps(_mm256_mul_ps(sinPoly, z), _mm256_set1_ps(S2));
+			sinPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sinPoly, z), x), x);
+
+			sine = _mm256_xor_ps(_mm256_blendv_ps(cosPoly, sinPoly, sinPolynomial), _mm256_xor_ps(signSin, swapSin));
+			cosine = _mm256_xor_ps(_mm256_blendv_ps(sinPoly, cosPoly, sinPolynomial), signCos);
+		}
+
+		CS381_AVX2 void SinCosAVX2(std::span<const float> radians, std::span<float> sines, std::span<float> cosines) {
+			assert(sines.size() >= radians.size() && cosines.size() >= radians.size());
+			size_t i = 0;
+			for(; i + 8 <= radians.size(); i += 8) {
+				__m256 sine, cosine;
+				SinCos8(_mm256_loadu_ps(radians.data() + i), sine, cosine);
+				_mm256_storeu_ps(sines.data() + i, sine);
+				_mm256_storeu_ps(cosines.data() + i, cosine);
+			}
+			for(; i < radians.size(); i++)
+				SinCosOne(radians[i], sines[i], cosines[i]);
+		}
+
+		CS381_AVX2 void HeadingToVelocityAVX2(std::span<const float> headingDegrees, std::span<const float> speeds, std::span<float> velocities) {
+			assert(speeds.size() >= headingDegrees.size() && velocities.size() >= headingDegrees.size() * 3);
+			const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(SignBit));
+			size_t i = 0;
+			for(; i + 8 <= headingDegrees.size(); i += 8) {
+				__m256 heading = _mm256_loadu_ps(headingDegrees.data() + i);
+				__m256 turns = _mm256_round_ps(_mm256_mul_ps(heading, _mm256_set1_ps(InverseFullTurn)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+				heading = _mm256_sub_ps(heading, _mm256_mul_ps(_mm256_set1_ps(360.0f), turns));
+
+				__m256 sine, cosine;
+				SinCos8(_mm256_mul_ps(heading, _mm256_set1_ps(DegreesToRadians)), sine, cosine);
+				__m256 speed = _mm256_loadu_ps(speeds.data() + i);
+				alignas(32) float x[8], z[8];
+				_mm256_store_ps(x, _mm256_mul_ps(cosine, speed));
+				_mm256_store_ps(z, _mm256_xor_ps(_mm256_mul_ps(sine, speed), signMask));
+
+				float* out = velocities.data() + i * 3;
+				for(int k = 0; k < 8; k++) {  // Interleave back into Vector3s
+					out[k * 3 + 0] = x[k];
+					out[k * 3 + 1] = 0;
+					out[k * 3 + 2] = z[k];
+				}
+			}
+			for(; i < headingDegrees.size(); i++)
+				HeadingToVelocityOne(headingDegrees[i], speeds[i], velocities.data() + i * 3);
+		}
+
+		CS381_AVX2 void IntegrateAVX2(std::span<float> out, std::span<const float> positions, std::span<const float> velocities, float dt) {
+			assert(out.size() >= positions.size() && velocities.size() >= positions.size());
+			const __m256 step = _mm256_set1_ps(dt);
+			size_t i = 0;
+			for(; i + 8 <= positions.size(); i += 8)
+				_mm256_storeu_ps(out.data() + i, _mm256_add_ps(_mm256_loadu_ps(positions.data() + i), _mm256_mul_ps(_mm256_loadu_ps(velocities.data() + i), step)));
+			for(; i < positions.size(); i++)
+				out[i] = positions[i] + velocities[i] * dt;
+		}
+
+		const Kernels avx2Kernels = {"avx2", SinCosAVX2, HeadingToVelocityAVX2, IntegrateAVX2};
+#endif // CS381_SIMD_AVX2
+
+#ifdef CS381_SIMD_NEON
+		inline void SinCos4(float32x4_t x, float32x4_t& sine, float32x4_t& cosine) {
+			const int32x4_t two = vdupq_n_s32(2), four = vdupq_n_s32(4);
+
+			uint32x4_t signSin = vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(SignBit));
+			x = vabsq_f32(x);
+			int32x4_t j = vcvtq_s32_f32(vmulq_f32(x, vdupq_n_f32(FourOverPi)));  // Truncates like the scalar cast
+			j = vandq_s32(vaddq_s32(j, vdupq_n_s32(1)), vdupq_n_s32(~1));
+			float32x4_t y = vcvtq_f32_s32(j);
+			uint32x4_t swapSin = vshlq_n_u32(vreinterpretq_u32_s32(vandq_s32(j, four)), 29);
+			uint32x4_t signCos = vshlq_n_u32(vreinterpretq_u32_s32(vbicq_s32(four, vsubq_s32(j, two))), 29);
+			uint32x4_t sinPolynomial = vceqq_s32(vandq_s32(j, two), vdupq_n_s32(0));
+
+			x = vsubq_f32(x, vmulq_f32(y, vdupq_n_f32(DP1)));
+			x = vsubq_f32(x, vmulq_f32(y, vdupq_n_f32(DP2)));
+			x = vsubq_f32(x, vmulq_f32(y, vdupq_n_f32(DP3)));
+			float32x4_t z = vmulq_f32(x, x);
+
+			float32x4_t cosPoly = vaddq_f32(vmulq_f32(vdupq_n_f32(C0), z), vdupq_n_f32(C1));
+			cosPoly = vaddq_f32(vmulq_f32(cosPoly, z), vdupq_n_f32(C2));
+			cosPoly = vmulq_f32(vmulq_f32(cosPoly, z), z);
+			cosPoly = vsubq_f32(cosPoly, vmulq_f32(z, vdupq_n_f32(0.5f)));
+			cosPoly = vaddq_f32(cosPoly, vdupq_n_f32(1.0f));
+
+			float32x4_t sinPoly = vaddq_f32(vmulq_f32(vdupq_n_f32(S0), z), vdupq_n_f32(S1));
+			sinPoly = vaddq_f32(vmulq_f32(sinPoly, z), vdupq_n_f32(S2));
+			sinPoly = vaddq_f32(vmulq_f32(vmulq_f32(sinPoly, z), x), x);
+
+			sine = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vbslq_f32(sinPolynomial, sinPoly, cosPoly)), veorq_u32(signSin, swapSin)));
+			cosine = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vbslq_f32(sinPolynomial, cosPoly, sinPoly)), signCos));
+		}
+
+		void SinCosNEON(std::span<const float> radians, std::span<float> sines, std::span<float> cosines) {
+			assert(sines.size() >= radians.size() && cosines.size() >= radians.size());
+			size_t i = 0;
+			for(; i + 4 <= radians.size(); i += 4) {
+				float32x4_t sine, cosine;
+				SinCos4(vld1q_f32(radians.data() + i), sine, cosine);
+				vst1q_f32(sines.data() + i, sine);
+				vst1q_f32(cosines.data() + i, cosine);
+			}
+			for(; i < radians.size(); i++)
+				SinCosOne(radians[i], sines[i], cosines[i]);
+		}
+
+		void HeadingToVelocityNEON(std::span<const float> headingDegrees, std::span<const float> speeds, std::span<float> velocities) {
+			assert(speeds.size() >= headingDegrees.size() && velocities.size() >= headingDegrees.size() * 3);
+			size_t i = 0;
+			for(; i + 4 <= headingDegrees.size(); i += 4) {
+				float32x4_t heading = vld1q_f32(headingDegrees.data() + i);
+				float32x4_t turns = vrndnq_f32(vmulq_f32(heading, vdupq_n_f32(InverseFullTurn)));
+				heading = vsubq_f32(heading, vmulq_f32(vdupq_n_f32(360.0f), turns));
+
+				float32x4_t sine, cosine;
+				SinCos4(vmulq_f32(heading, vdupq_n_f32(DegreesToRadians)), sine, cosine);
+				float32x4_t speed = vld1q_f32(speeds.data() + i);
+				float32x4x3_t out = {{vmulq_f32(cosine, speed), vdupq_n_f32(0), vnegq_f32(vmulq_f32(sine, speed))}};
+				vst3q_f32(velocities.data() + i * 3, out);  // Interleaving store straight into Vector3s
+			}
+			for(; i < headingDegrees.size(); i++)
+				HeadingToVelocityOne(headingDegrees[i], speeds[i], velocities.data() + i * 3);
+		}
+
+		void IntegrateNEON(std::span<float> out, std::span<const float> positions, std::span<const float> velocities, float dt) {
+			assert(out.size() >= positions.size() && velocities.size() >= positions.size());
+			const float32x4_t step = vdupq_n_f32(dt);
+			size_t i = 0;
+			for(; i + 4 <= positions.size(); i += 4)
+				vst1q_f32(out.data() + i, vaddq_f32(vld1q_f32(positions.data() + i), vmulq_f32(vld1q_f32(velocities.data() + i), step)));
+			for(; i < positions.size(); i++)
+				out[i] = positions[i] + velocities[i] * dt;
+		}
+
+		const Kernels neonKernels = {"neon", SinCosNEON, HeadingToVelocityNEON, IntegrateNEON};
+#endif // CS381_SIMD_NEON
+	}
+
+	const Kernels& ScalarKernels() { return scalarKernels; }
+
+	const Kernels& ActiveKernels() {
+		static const Kernels& active = []() -> const Kernels& {
+#if defined(CS381_SIMD_AVX2)
+			if(__builtin_cpu_supports("avx2"))
+				return avx2Kernels;
+#elif defined(CS381_SIMD_NEON)
+			return neonKernels;  // NEON is always there on 64 bit ARM
+#endif
+			return scalarKernels;
+		}();
+		return active;
+	}
+}
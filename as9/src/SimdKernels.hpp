@@ -0,0 +1,37 @@
+#ifndef SIMD_KERNELS_HPP
+#define SIMD_KERNELS_HPP
+
+#include <span>
+
+namespace cs381::simd {
+
+	// Batch kernels over component columns (see SplitComponent in ECS.hpp)
+	// Each kernel has an AVX2 (8 lanes), NEON (4 lanes) and scalar version, the best one the CPU supports is picked
+	// at runtime. Every version runs the same operations in the same order (no FMA), so on a given machine they agree
+	// bit for bit and the choice of ISA never changes the simulation
+	struct Kernels {
+		const char* name;
+
+		// sines[i], cosines[i] = sin(radians[i]), cos(radians[i])
+		// Cephes style: Cody-Waite reduction to [-pi/4, pi/4] then degree 7/8 polynomials
+		// Absolute error is below 2e-7 for |x| <= 8192 (the reduction loses precision beyond that, reduce the angle first)
+		void (*sinCos)(std::span<const float> radians, std::span<float> sines, std::span<float> cosines);
+
+		// velocities[i] = {cos(h) * speeds[i], 0, -sin(h) * speeds[i]} where h = headingDegrees[i] in radians
+		// velocities holds 3 floats (a Vector3) per entity. Headings are wrapped to [-180, 180] first, which is exact for
+		// |heading| <= 1e8 degrees (past ~1.3e8 the wrap rounds and the direction is wrong), keep stored headings wrapped
+		void (*headingToVelocity)(std::span<const float> headingDegrees, std::span<const float> speeds, std::span<float> velocities);
+
+		// out[i] = positions[i] + velocities[i] * dt, over flat float arrays (3 floats per Vector3), out may alias positions
+		void (*integrate)(std::span<float> out, std::span<const float> positions, std::span<const float> velocities, float dt);
+	};
+
+	const Kernels& ScalarKernels();  // Reference implementation, available everywhere
+	const Kernels& ActiveKernels();  // Fastest implementation this CPU supports (chosen once, on first use)
+
+	inline void SinCos(std::span<const float> radians, std::span<float> sines, std::span<float> cosines) { ActiveKernels().sinCos(radians, sines, cosines); }
+	inline void HeadingToVelocity(std::span<const float> headingDegrees, std::span<const float> speeds, std::span<float> velocities) { ActiveKernels().headingToVelocity(headingDegrees, speeds, velocities); }
+	inline void Integrate(std::span<float> out, std::span<const float> positions, std::span<const float> velocities, float dt) { ActiveKernels().integrate(out, positions, velocities, dt); }
+}
+
+#endif // SIMD_KERNELS_HPP
@@ -0,0 +1,204 @@
+#include "Simulation.hpp"
+#include <cmath>
+#include <functional>
+#include "Profiler.hpp"
+#include "SimdKernels.hpp"
+
+size_t globalComponentCounter = 0;
+
+namespace cs381 {
+
+    // View a run of Vector3s as the flat float array the batch kernels work on
+    static std::span<float> Floats(std::span<Vector3> vectors) {
+        return { &vectors.data()->x, vectors.size() * 3 };
+    }
+
+    Simulation::Simulation(uint64_t seed, size_t workerCount) : random(seed), seed(seed), workers(workerCount) {}
+
+    EntityID Simulation::CreateCar(Vector3 pos, float maxSpeed, float accel, float turnRate) {
+        EntityID e = world.CreateEntity();
+        world.AddComponent<TransformComponent>(e) = { pos, {0, 0, 0}, {6, 6, 6} };
+        world.AddComponent<VelocityComponent>(e) = { {0, 0, 0}, 0.0f, 0.0f, maxSpeed, accel };
+        world.AddComponent<Physics2DComponent>(e) = { 0.0f, turnRate };
+        return e;
+    }
+
+    EntityID Simulation::CreateGoal(Vector3 pos) {
+        EntityID e = world.CreateEntity();
+        world.AddComponent<TransformComponent>(e) = { pos, {0, 0, 0}, {2, 2, 2} };
+        goalEntity = e;
+        return e;
+    }
+
+    void Simulation::ScatterCars(int count, int extent) {
+        for (int i = 0; i < count; ++i) {
+            Vector3 pos = { (float)random.Range(-extent, extent), 0.0f, (float)random.Range(-extent, extent) };
+            CreateCar(pos, 10.0f, 4.0f, 60.0f);
+        }
+    }
+
+    void Simulation::SpawnGame(int cars) {
+        CreateCar({ 0.0f, 0.0f, 0.0f }, 10.0f, 4.0f, 60.0f);  // The first car is selected
+        CreateGoal({ 0.0f, 1.0f, -10.0f });
+        ScatterCars(cars - 1);
+        SyncEntities();
+    }
+
+    void Simulation::SnapshotPrevious() {
+        auto positions = world.GetFieldStorage<&TransformComponent::position>().Span<Vector3>();
+        previousPositions.assign(positions.begin(), positions.end());
+        auto headings = world.GetFieldStorage<&Physics2DComponent::heading>().Span<float>();
+        previousHeadings.assign(headings.begin(), headings.end());
+    }
+
+    // Sync point: runs on the main thread before the systems start
+    // Starts this tick's write buffers from the current state
+    // Only the columns some system writes are buffered, each one is copied whole every tick
+    void Simulation::BeginTick() {
+        CS381_PROFILE_ZONE("BeginTick");
+        SnapshotPrevious();
+        world.BeginWriteFields<&TransformComponent::position, &VelocityComponent::velocity,
+            &VelocityComponent::speed, &Physics2DComponent::heading>();
+    }
+
+    // Sync point: runs on the main thread once the systems have finished
+    // Publishes everything the systems wrote this tick
+    void Simulation::SwapBuffers() {
+        CS381_PROFILE_ZONE("SwapBuffers");
+        world.SwapFieldBuffers<&TransformComponent::position, &VelocityComponent::velocity,
+            &VelocityComponent::speed, &Physics2DComponent::heading>();
+    }
+
+    void Simulation::SyncEntities() {
+        bool first = syncedEntities == 0;
+        world.SyncEntities();
+        for (EntityID e = syncedEntities; e < world.entityMasks.size(); ++e) {
+            if (world.HasComponent<VelocityComponent>(e)) entityOrder.push_back(e);
+        }
+        syncedEntities = world.entityMasks.size();
+        if (first) SnapshotPrevious();  // Nothing to interpolate from yet
+    }
+
+    void Simulation::Select(const InputSnapshot& input) {
+        if (input.selectNext) {
+            selectedIndex = (selectedIndex + 1) % entityOrder.size();
+        }
+    }
+
+    void Simulation::Tick(const InputSnapshot& input, float dt) {
+        CS381_PROFILE_ZONE("Tick");
+        BeginTick();
+
+        const std::function<void()> tasks[] = {
+            [&] { InputSystem(input, dt); },
+            [&] { Physics2DSystem(); },
+            [&] { KinematicsSystem(dt); },
+            [&] { GoalSystem(); }
+        };
+        workers.Run(tasks);
+        SwapBuffers();
+        SyncEntities();
+        ticks++;
+    }
+
+    int Simulation::Frame(FixedTimestep& timestep, const InputSnapshot& input, float frameTime) {
+        Select(input);
+
+        // The simulation always advances in fixed ticks, however long the frame took
+        int steps = timestep.Advance(frameTime);
+        for (int i = 0; i < steps; ++i) {
+            Tick(input, timestep.StepSize());
+        }
+        return steps;
+    }
+
+    uint64_t Simulation::StateHash() {
+        uint64_t hash = 14695981039346656037ull;  // FNV-1a
+        auto mix = [&hash](const void* data, size_t size) {
+            for (size_t i = 0; i < size; ++i) {
+                hash ^= ((const uint8_t*)data)[i];
+                hash *= 1099511628211ull;
+            }
+        };
+        for (auto* storage : { &world.GetFieldStorage<&TransformComponent::position>(), &world.GetFieldStorage<&VelocityComponent::speed>(), &world.GetFieldStorage<&Physics2DComponent::heading>() }) {
+            mix(storage->data.data(), storage->data.size());
+        }
+        mix(&score, sizeof(score));
+        mix(&selectedIndex, sizeof(selectedIndex));
+        return hash;
+    }
+
+    // Both simulation kernels run over runs of consecutive matching entities, so they stream whole column slices (see SimdKernels.hpp)
+    void Simulation::KinematicsSystem(float dt) {
+        CS381_PROFILE_ZONE("KinematicsSystem");
+        auto positions = world.GetFieldStorage<&TransformComponent::position>().Span<Vector3>();
+        auto nextPositions = world.GetWriteFieldStorage<&TransformComponent::position>().Span<Vector3>();
+        auto velocities = world.GetFieldStorage<&VelocityComponent::velocity>().Span<Vector3>();
+        for (auto [begin, end] : world.View<TransformComponent, VelocityComponent>().Runs()) {
+            simd::Integrate(Floats(nextPositions.subspan(begin, end - begin)), Floats(positions.subspan(begin, end - begin)), Floats(velocities.subspan(begin, end - begin)), dt);
+        }
+    }
+
+    void Simulation::Physics2DSystem() {
+        CS381_PROFILE_ZONE("Physics2DSystem");
+        auto headings = world.GetFieldStorage<&Physics2DComponent::heading>().Span<float>();
+        auto speeds = world.GetFieldStorage<&VelocityComponent::speed>().Span<float>();
+        auto nextVelocities = world.GetWriteFieldStorage<&VelocityComponent::velocity>().Span<Vector3>();
+        for (auto [begin, end] : world.View<Physics2DComponent, VelocityComponent>().Runs()) {
+            simd::HeadingToVelocity(headings.subspan(begin, end - begin), speeds.subspan(begin, end - begin), Floats(nextVelocities.subspan(begin, end - begin)));
+        }
+    }
+
+    void Simulation::InputSystem(const InputSnapshot& input, float dt) {
+        CS381_PROFILE_ZONE("InputSystem");
+        EntityID selected = Selected();
+        if (!world.HasComponent<VelocityComponent>(selected)) return;
+
+        const VelocityComponent vel = world.GetComponent<VelocityComponent>(selected);
+
+        if (world.HasComponent<Physics2DComponent>(selected)) {
+            float speed = vel.speed;
+            if (input.accelerate) speed = std::min(speed + vel.acceleration * dt, vel.maxSpeed);
+            if (input.decelerate) speed = std::max(speed - vel.acceleration * dt, -vel.maxSpeed);
+            world.WriteField<&VelocityComponent::speed>(selected) = speed;
+
+            const Physics2DComponent phys = world.GetComponent<Physics2DComponent>(selected);
+            float heading = phys.heading;
+            if (input.turnLeft) heading += phys.turnRate * dt;
+            if (input.turnRight) heading -= phys.turnRate * dt;
+            world.WriteField<&Physics2DComponent::heading>(selected) = std::remainder(heading, 360.0f);  // Keep it in [-180, 180], see HeadingToVelocity
+        }
+    }
+
+    void Simulation::GoalSystem() {
+        CS381_PROFILE_ZONE("GoalSystem");
+        EntityID car = Selected();
+        EntityID goal = goalEntity;
+
+        Vector3 carPos = world.GetField<&TransformComponent::position>(car);
+        Vector3 goalPos = world.GetField<&TransformComponent::position>(goal);
+
+        float dx = carPos.x - goalPos.x;
+        float dz = carPos.z - goalPos.z;
+        float distance = sqrtf(dx * dx + dz * dz);
+        goalDistance = distance;
+
+        float carRadius = 1.5f;
+        float goalRadius = 2.0f;
+        float triggerDistance = carRadius + goalRadius;
+
+        if (distance < triggerDistance) {
+            if (!alreadyScored) {
+                score++;
+                alreadyScored = true;
+
+                float offsetX = random.Range(-30, 30);
+                float offsetZ = random.Range(-30, 30);
+                world.WriteField<&TransformComponent::position>(goal) = { offsetX, goalPos.y, offsetZ };
+                previousPositions[goal] = world.WriteField<&TransformComponent::position>(goal);  // Teleport, don't interpolate
+            }
+        } else {
+            alreadyScored = false;
+        }
+    }
+}
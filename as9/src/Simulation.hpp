@@ -0,0 +1,135 @@
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+
+// The Conenado game rules (driving, kinematics, goal scoring) without any windowing, input polling, drawing or audio
+// Only raylib's plain structs and the header only raymath are used, so this builds into a library which runs on
+// machines without a display or GPU (see server.cpp), the game (as9.cpp) draws whatever the simulation holds
+
+#include <raylib.h>
+#include <raymath.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "ECS.hpp"
+#include "FrameWorkerPool.hpp"
+#include "FixedTimestep.hpp"
+
+using EntityID = cs381::Entity;
+
+struct TransformComponent {
+    Vector3 position;
+    Vector3 rotation;
+    Vector3 scale;
+};
+
+// Transforms are stored one column per field, so kinematics and interpolation only stream positions
+template<> struct cs381::SplitComponent<TransformComponent> {
+    static constexpr auto fields = std::make_tuple(&TransformComponent::position, &TransformComponent::rotation, &TransformComponent::scale);
+};
+
+struct VelocityComponent {
+    Vector3 velocity;
+    float speed;
+    float targetSpeed;
+    float maxSpeed;
+    float acceleration;
+};
+
+struct Physics2DComponent {
+    float heading;
+    float turnRate;
+};
+
+// Velocity and physics are split too, so the batch kernels can run over the heading, speed and velocity columns
+template<> struct cs381::SplitComponent<VelocityComponent> {
+    static constexpr auto fields = std::make_tuple(&VelocityComponent::velocity, &VelocityComponent::speed, &VelocityComponent::targetSpeed, &VelocityComponent::maxSpeed, &VelocityComponent::acceleration);
+};
+template<> struct cs381::SplitComponent<Physics2DComponent> {
+    static constexpr auto fields = std::make_tuple(&Physics2DComponent::heading, &Physics2DComponent::turnRate);
+};
+
+// Input is sampled once per frame (from the keyboard, a script...), systems only ever see this immutable copy
+struct InputSnapshot {
+    bool accelerate = false;
+    bool decelerate = false;
+    bool turnLeft = false;
+    bool turnRight = false;
+    bool selectNext = false;
+};
+
+namespace cs381 {
+
+    // Small seeded random number generator (splitmix64), the simulation owns one so a seed reproduces a whole game
+    // independently of raylib's global GetRandomValue state
+    struct Random {
+        uint64_t state;
+
+        explicit Random(uint64_t seed = 0) : state(seed) {}
+
+        uint64_t Next() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        int Range(int min, int max) {  // Integer in [min, max], like GetRandomValue
+            if (min > max) std::swap(min, max);
+            return min + (int)(Next() % ((uint64_t)((int64_t)max - min) + 1));
+        }
+    };
+
+    struct Simulation {
+        // Every entity lives in the world scene, storage grows with the number of entities so there is no cap
+        // State the simulation systems share (transform, velocity, physics) is double buffered: systems read the scene's
+        // components (the last tick) and write WriteComponent/WriteField (this tick) so they can all run at once
+        // Each field is written by exactly one system, only written fields are buffered and they are swapped after every tick
+        Scene<ComponentStorage> world;
+        std::vector<Vector3> previousPositions;  // Position column as of the previous tick, for render interpolation
+        std::vector<float> previousHeadings;  // Heading column as of the previous tick, likewise
+        std::vector<EntityID> entityOrder;  // Cars, in the order TAB cycles through them
+        int selectedIndex = 0;
+
+        int score = 0;
+        bool alreadyScored = false;
+        float goalDistance = 0;
+        EntityID goalEntity = 0;
+
+        Random random;
+        uint64_t seed;
+
+        Simulation(uint64_t seed = 0, size_t workerCount = 3);  // Default is one worker per simulation system, the calling thread helps out too
+
+        // Main thread only (between ticks), systems that want to spawn should world.ReserveEntity() and add components after the next SyncEntities
+        EntityID CreateCar(Vector3 pos, float maxSpeed, float accel, float turnRate);
+        EntityID CreateGoal(Vector3 pos);
+        void ScatterCars(int count, int extent = 48);  // Adds cars at random spots in [-extent, extent] on the ground
+        void SpawnGame(int cars);  // The standard Conenado layout: a selected car, the goal and cars - 1 scattered cars
+
+        EntityID Selected() const { return entityOrder[selectedIndex]; }
+
+        void Select(const InputSnapshot& input);  // Key presses are per frame events, so selection stays outside the fixed step
+        void Tick(const InputSnapshot& input, float dt);  // Advance the game by one fixed step
+        int Frame(FixedTimestep& timestep, const InputSnapshot& input, float frameTime);  // Select, then run however many fixed steps a frame of frameTime covers, returns the step count
+        uint64_t Ticks() const { return ticks; }
+        uint64_t StateHash();  // Hash of the simulated state, two runs of the same replay must produce the same hash
+
+        void SyncEntities();  // Pick up entities created since the last sync (the first sync also snapshots positions and headings)
+
+    protected:
+        FrameWorkerPool workers;
+        EntityID syncedEntities = 0;
+        uint64_t ticks = 0;
+
+        void SnapshotPrevious();
+        void BeginTick();
+        void SwapBuffers();
+
+        void KinematicsSystem(float dt);
+        void Physics2DSystem();
+        void InputSystem(const InputSnapshot& input, float dt);
+        void GoalSystem();
+    };
+}
+
+#endif // SIMULATION_HPP
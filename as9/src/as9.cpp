@@ -3,14 +3,18 @@
 #include <cmath>
 #include <string>
 #include <iostream>
-#include <thread>
-#include <mutex>
+#include <cstdlib>
+#include <cstring>
+#include <random>
 #include "skybox.hpp"
-#include "ECS.hpp"
+#include "DebugDraw.hpp"
+#include "FixedTimestep.hpp"
+#include "Profiler.hpp"
+#include "Replay.hpp"
+#include "Simulation.hpp"
 
 constexpr int SCREEN_WIDTH = 800;
 constexpr int SCREEN_HEIGHT = 600;
-constexpr int MAX_ENTITIES = 100;
 
 std::string chatInput;
 std::vector<std::string> chatMessages;
@@ -18,48 +22,22 @@ bool chatActive = false;
 const int maxChatMessages = 5;
 
 
-using EntityID = size_t;
-
-inline EntityID CreateEntity() {
-    static EntityID next = 0;
-    return next++;
-}
-
-struct TransformComponent {
-    Vector3 position;
-    Vector3 rotation;
-    Vector3 scale;
-};
-
+// Drawing only, the game rules never look at it (see Simulation.hpp)
 struct RenderComponent {
     raylib::Model* model;
-    bool showBoundingBox;
-};
-
-struct VelocityComponent {
-    Vector3 velocity;
-    float speed;
-    float targetSpeed;
-    float maxSpeed;
-    float acceleration;
-};
-
-struct Physics2DComponent {
-    float heading;
-    float turnRate;
+    bool showBoundingBox;  // Included when all bounds are shown
+    BoundingBox bounds;  // Model space, drawn oriented by the entity's matrix
 };
 
-std::vector<TransformComponent> transformPool(MAX_ENTITIES);
-std::vector<RenderComponent> renderPool(MAX_ENTITIES);
-std::vector<VelocityComponent> velocityPool(MAX_ENTITIES);
-std::vector<Physics2DComponent> physics2DPool(MAX_ENTITIES);
-std::vector<bool> hasTransform(MAX_ENTITIES, false);
-std::vector<bool> hasRender(MAX_ENTITIES, false);
-std::vector<bool> hasVelocity(MAX_ENTITIES, false);
-std::vector<bool> hasPhysics2D(MAX_ENTITIES, false);
-std::vector<bool> selectionPool(MAX_ENTITIES, false);
-
-std::mutex entityMutex;
+InputSnapshot SampleInput() {
+    return {
+        IsKeyDown(KEY_W),
+        IsKeyDown(KEY_S),
+        IsKeyDown(KEY_A),
+        IsKeyDown(KEY_D),
+        IsKeyPressed(KEY_TAB)
+    };
+}
 
 raylib::Model carModel;
 raylib::Model goalModel;
@@ -67,138 +45,55 @@ raylib::Texture skyTex;
 cs381::SkyBox* skybox;
 
 raylib::Camera3D camera;
-std::vector<EntityID> entityOrder;
-int selectedIndex = 0;
-
-int score = 0;
-bool alreadyScored = false;
-EntityID goalEntity;
-
-EntityID CreateCar(Vector3 pos, float maxSpeed, float accel, float turnRate, raylib::Model& model) {
-    EntityID e = CreateEntity();
-    transformPool[e] = { pos, {0, 0, 0}, {6, 6, 6} };
-    renderPool[e] = { &model, true };
-    velocityPool[e] = { {0, 0, 0}, 0.0f, 0.0f, maxSpeed, accel };
-    physics2DPool[e] = { 0.0f, turnRate };
-    hasTransform[e] = hasRender[e] = hasVelocity[e] = hasPhysics2D[e] = true;
-    entityMutex.lock();
-    entityOrder.push_back(e);
-    entityMutex.unlock();
-    return e;
-}
-
-EntityID CreateGoal(Vector3 pos, raylib::Model& model) {
-    EntityID e = CreateEntity();
-    transformPool[e] = { pos, {0, 0, 0}, {2, 2, 2} };
-    renderPool[e] = { &model, false };
-    hasTransform[e] = hasRender[e] = true;
-    return e;
-}
-
-void KinematicsSystem(float dt) {
-    for (EntityID e = 0; e < MAX_ENTITIES; ++e) {
-        if (hasTransform[e] && hasVelocity[e]) {
-            transformPool[e].position = Vector3Add(transformPool[e].position, Vector3Scale(velocityPool[e].velocity, dt));
-        }
+BoundingBox carBounds, goalBounds;
+bool showAllBounds = false;
+
+// Attach a model to every entity the simulation created since the last call (entities are never destroyed, so the
+// ones below attachedEntities have all been seen)
+size_t attachedEntities = 0;
+void AttachModels(cs381::Simulation& sim) {
+    auto& world = sim.world;
+    for (EntityID e = attachedEntities; e < world.entityMasks.size(); ++e) {
+        if (!world.HasComponent<TransformComponent>(e) || world.HasComponent<RenderComponent>(e)) continue;
+        if (e == sim.goalEntity) world.AddComponent<RenderComponent>(e) = { &goalModel, false, goalBounds };
+        else world.AddComponent<RenderComponent>(e) = { &carModel, true, carBounds };
     }
+    attachedEntities = world.entityMasks.size();
 }
 
-void Physics2DSystem(float dt) {
-    for (EntityID e = 0; e < MAX_ENTITIES; ++e) {
-        if (hasPhysics2D[e] && hasVelocity[e]) {
-            float headingRad = physics2DPool[e].heading * DEG2RAD;
-            velocityPool[e].velocity = {
-                cosf(headingRad) * velocityPool[e].speed,
-                0,
-                -sinf(headingRad) * velocityPool[e].speed
-            };
+// alpha is how far we are between the previous and current simulation tick
+// Highlights are added to debug, which draws them all at once after the scene
+void RenderSystem(cs381::Simulation& sim, float alpha, cs381::DebugDraw& debug) {
+    auto& world = sim.world;
+    EntityID selected = sim.Selected();
+    world.View<TransformComponent, RenderComponent>().ForEach([&](EntityID e, auto transform, RenderComponent& render) {
+        Vector3 current = transform.template Field<&TransformComponent::position>();
+        Vector3 position = e < sim.previousPositions.size() ? Vector3Lerp(sim.previousPositions[e], current, alpha) : current;  // Spawned since the last tick, nothing to interpolate from
+        Vector3 scale = transform.template Field<&TransformComponent::scale>();
+
+        Matrix matrix = MatrixIdentity();
+        matrix = MatrixMultiply(matrix, MatrixScale(scale.x, scale.y, scale.z));
+
+        if (world.HasComponent<Physics2DComponent>(e)) {
+            float heading = world.GetField<&Physics2DComponent::heading>(e);
+            if (e < sim.previousHeadings.size()) heading = cs381::LerpDegrees(sim.previousHeadings[e], heading, alpha);
+            Matrix rotationMatrix = MatrixRotateY(heading * DEG2RAD);
+            matrix = MatrixMultiply(matrix, rotationMatrix);
         }
-    }
-}
-
-void RenderSystem() {
-    for (EntityID e = 0; e < MAX_ENTITIES; ++e) {
-        if (hasTransform[e] && hasRender[e]) {
-            Matrix transform = MatrixIdentity();
-            transform = MatrixMultiply(transform, MatrixScale(transformPool[e].scale.x, transformPool[e].scale.y, transformPool[e].scale.z));
-
-            if (hasPhysics2D[e]) {
-                Matrix rotationMatrix = MatrixRotateY(physics2DPool[e].heading * DEG2RAD);
-                transform = MatrixMultiply(transform, rotationMatrix);
-            }
-
-            transform = MatrixMultiply(transform, MatrixTranslate(
-                transformPool[e].position.x,
-                transformPool[e].position.y,
-                transformPool[e].position.z
-            ));
-
-            renderPool[e].model->transform = transform;
-            renderPool[e].model->Draw({});
-
-            if (selectionPool[e]) {
-                DrawBoundingBox(renderPool[e].model->GetBoundingBox(), RED);
-            }
-            if (e == goalEntity) {
-                DrawBoundingBox(renderPool[e].model->GetBoundingBox(), GREEN);
-            }
-        }
-    }
-}
-
-void InputSystem(float dt) {
-    EntityID selected = entityOrder[selectedIndex];
-    if (!hasVelocity[selected]) return;
-
-    auto& vel = velocityPool[selected];
-
-    if (hasPhysics2D[selected]) {
-        if (IsKeyDown(KEY_W)) vel.speed = std::min(vel.speed + vel.acceleration * dt, vel.maxSpeed);
-        if (IsKeyDown(KEY_S)) vel.speed = std::max(vel.speed - vel.acceleration * dt, -vel.maxSpeed);
-
-        auto& phys = physics2DPool[selected];
-        if (IsKeyDown(KEY_A)) phys.heading += phys.turnRate * dt;
-        if (IsKeyDown(KEY_D)) phys.heading -= phys.turnRate * dt;
-    }
-}
 
-void SelectionSystem() {
-    if (IsKeyPressed(KEY_TAB)) {
-        selectionPool[entityOrder[selectedIndex]] = false;
-        selectedIndex = (selectedIndex + 1) % entityOrder.size();
-        selectionPool[entityOrder[selectedIndex]] = true;
-    }
-}
-
-void GoalSystem() {
-    EntityID car = entityOrder[selectedIndex];
-    EntityID goal = goalEntity;
-
-    Vector3 carPos = transformPool[car].position;
-    Vector3 goalPos = transformPool[goal].position;
-
-    float dx = carPos.x - goalPos.x;
-    float dz = carPos.z - goalPos.z;
-    float distance = sqrtf(dx * dx + dz * dz);
+        matrix = MatrixMultiply(matrix, MatrixTranslate(position.x, position.y, position.z));
 
-    float carRadius = 1.5f;
-    float goalRadius = 2.0f;
-    float triggerDistance = carRadius + goalRadius;
+        render.model->transform = matrix;
+        render.model->Draw({});
 
-    DrawText(TextFormat("Distance to Goal: %.2f", distance), 20, 50, 20, GRAY);
-
-    if (distance < triggerDistance) {
-        if (!alreadyScored) {
-            score++;
-            alreadyScored = true;
-
-            float offsetX = GetRandomValue(-30, 30);
-            float offsetZ = GetRandomValue(-30, 30);
-            transformPool[goal].position = { offsetX, goalPos.y, offsetZ };
+        if (e == selected) {
+            debug.Box(render.bounds, matrix, RED);
+        } else if (e == sim.goalEntity) {
+            debug.Box(render.bounds, matrix, GREEN);
+        } else if (showAllBounds && render.showBoundingBox) {
+            debug.Box(render.bounds, matrix, DARKGRAY);
         }
-    } else {
-        alreadyScored = false;
-    }
+    });
 }
 
 void ChatSystem() {
@@ -228,8 +123,9 @@ void ChatSystem() {
     }
 }
 
-void DrawUI() {
-    DrawText(TextFormat("Score: %d", score), 20, 20, 20, DARKGRAY);
+void DrawUI(const cs381::Simulation& sim) {
+    DrawText(TextFormat("Score: %d", sim.score), 20, 20, 20, DARKGRAY);
+    DrawText(TextFormat("Distance to Goal: %.2f", sim.goalDistance), 20, 50, 20, GRAY);
 
     int chatX = 20;
     int chatY = SCREEN_HEIGHT - 150;
@@ -245,8 +141,68 @@ void DrawUI() {
     }
 }
 
+// F3 overlay: the last frames' times as a graph (the line is 60fps) and each zone's average/max time per frame
+void DrawProfiler() {
+    auto& profiler = cs381::Profiler::Instance();
+    const int width = 300, graphHeight = 80, x = SCREEN_WIDTH - width - 10, y = 50;
+    const float msPerPixel = 50.0f / graphHeight;  // Graph tops out at 50ms
+
+    auto stats = profiler.Summary();
+    int height = graphHeight + 30 + (int)stats.size() * 14;
+    DrawRectangle(x - 5, y - 5, width + 10, height + 10, Fade(BLACK, 0.6f));
+
+    float barWidth = (float)width / cs381::Profiler::FrameCapacity;
+    for (size_t i = 0; i < profiler.FrameCount(); ++i) {
+        float ms = profiler.GetFrame(i).Milliseconds();
+        float barHeight = std::min(ms / msPerPixel, (float)graphHeight);
+        Color color = ms > 1000.0f / 30 ? RED : ms > 1000.0f / 60 + 1 ? ORANGE : GREEN;
+        DrawRectangleRec({ x + i * barWidth, y + graphHeight - barHeight, std::max(barWidth, 1.0f), barHeight }, color);
+    }
+    int targetY = y + graphHeight - (int)(1000.0f / 60 / msPerPixel);
+    DrawLine(x, targetY, x + width, targetY, Fade(WHITE, 0.5f));
+
+    float lastMs = profiler.FrameCount() ? profiler.GetFrame(profiler.FrameCount() - 1).Milliseconds() : 0;
+    DrawText(TextFormat("frame %.2fms  (F4 saves a trace)", lastMs), x, y + graphHeight + 6, 10, WHITE);
+    int rowY = y + graphHeight + 24;
+    for (auto& zone : stats) {
+        DrawText(zone.name, x + zone.depth * 10, rowY, 10, LIGHTGRAY);
+        DrawText(TextFormat("%6.3f avg %6.3f max", zone.averageMs, zone.maxMs), x + width - 130, rowY, 10, LIGHTGRAY);
+        rowY += 14;
+    }
+}
+
+
+// Usage: as9 [cone count] [--record file] [--replay file] [--speed x], extra cones are scattered around the field and
+// can be selected with TAB. --record saves the session (see Replay.hpp), --replay plays one back at --speed times
+// real time instead of reading the keyboard (the cone count then comes from the file)
+int main(int argc, char** argv) {
+    int coneCount = 1;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    float replaySpeed = 1;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--record") && hasValue) recordPath = argv[++i];
+        else if (!strcmp(argv[i], "--replay") && hasValue) replayPath = argv[++i];
+        else if (!strcmp(argv[i], "--speed") && hasValue) replaySpeed = std::max<float>(std::atof(argv[++i]), 0);
+        else coneCount = std::max(std::atoi(argv[i]), 1);
+    }
+
+    cs381::ReplayHeader header = { std::random_device{}(), (uint32_t)coneCount, 60.0f };
+    cs381::InputReplay replay;
+    if (replayPath) {
+        if (!replay.Load(replayPath)) {
+            std::cerr << "Couldn't load replay " << replayPath << std::endl;
+            return 1;
+        }
+        header = replay.header;
+    }
+    cs381::InputRecorder recorder;
+    if (recordPath && !recorder.Open(recordPath, header)) {
+        std::cerr << "Couldn't write replay " << recordPath << std::endl;
+        return 1;
+    }
 
-int main() {
     raylib::Window window(SCREEN_WIDTH, SCREEN_HEIGHT, "Conenado");
     SetTargetFPS(60);
     camera = raylib::Camera3D({ 0.0f, 25.0f, 50.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 75.0f, CAMERA_PERSPECTIVE);
@@ -254,6 +210,10 @@ int main() {
     carModel = raylib::Model("../assets/Kenny Car Kit/cone.glb");
     goalModel = raylib::Mesh::Sphere(1.0f, 16, 16).LoadModelFrom();
     goalModel.materials[0].maps[MATERIAL_MAP_DIFFUSE].color = GREEN;
+    carBounds = carModel.GetBoundingBox();  // Transforms are still the identity, so these are model space
+    goalBounds = goalModel.GetBoundingBox();
+    cs381::DebugDraw debug;
+    debug.Init();
 
     cs381::SkyBox sky("textures/skybox.png");
 
@@ -264,15 +224,35 @@ int main() {
     raylib::Texture grassTexture = raylib::Texture("../assets/textures/grass.jpg");
     grass.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = grassTexture;
 
-    EntityID car = CreateCar({ 0.0f, 0.0f, 0.0f }, 10.0f, 4.0f, 60.0f, carModel);
-    selectionPool[car] = true;
-    goalEntity = CreateGoal({ 0.0f, 1.0f, -10.0f }, goalModel);
-    transformPool[goalEntity].scale = { 2.0f, 2.0f, 2.0f };
+    auto& profiler = cs381::Profiler::Instance();
+    profiler.SetThreadName("Main");
+    bool showProfiler = false;
 
-    bool gameStarted = false;
+    cs381::Simulation sim(header.seed);
+    sim.SpawnGame(header.cars);
+    AttachModels(sim);
+
+    cs381::FixedTimestep timestep(header.tickRate);
+    float replayBudget = 0;  // Real time (scaled by the replay speed) not yet spent on recorded frames
+
+    bool gameStarted = replayPath != nullptr;
+    if (gameStarted) PlayMusicStream(ambientMusic);
 
     while (!window.ShouldClose()) {
         float dt = GetFrameTime();
+        profiler.BeginFrame();
+
+        if (IsKeyPressed(KEY_F1)) debug.enabled = !debug.enabled;
+        if (IsKeyPressed(KEY_F2)) showAllBounds = !showAllBounds;
+        if (IsKeyPressed(KEY_F3)) {
+            showProfiler = !showProfiler;
+            profiler.SetEnabled(showProfiler);
+        }
+        if (IsKeyPressed(KEY_F4) && profiler.FrameCount() > 0) {
+            const char* path = "as9_trace.json";
+            if (profiler.ExportChromeTrace(path)) std::cout << "Saved the last " << profiler.FrameCount() << " frames to " << path << std::endl;
+            else std::cerr << "Couldn't write " << path << std::endl;
+        }
 
         window.BeginDrawing();
         window.ClearBackground(RAYWHITE);
@@ -295,32 +275,59 @@ int main() {
                 PlayMusicStream(ambientMusic);
             }
         } else {
-            UpdateMusicStream(ambientMusic);
-
-            std::thread inputThread(InputSystem, dt);
-            std::thread selectionThread(SelectionSystem);
-            std::thread physicsThread(Physics2DSystem, dt);
-            std::thread kinematicsThread(KinematicsSystem, dt);
-            std::thread goalThread(GoalSystem);
-
-            inputThread.join();
-            selectionThread.join();
-            physicsThread.join();
-            kinematicsThread.join();
-            goalThread.join();
+            {
+                CS381_PROFILE_ZONE("UpdateMusicStream");
+                UpdateMusicStream(ambientMusic);
+            }
+            if (replayPath) {
+                CS381_PROFILE_ZONE("Simulation");
+                // Recorded frames are played back whole, as many as fit in this frame's (sped up) time
+                replayBudget += dt * replaySpeed;
+                while (!replay.Done() && replay.Peek().frameTime <= replayBudget) {
+                    const cs381::ReplayFrame& frame = replay.Next();
+                    replayBudget -= frame.frameTime;
+                    recorder.Record(frame.frameTime, frame.input);
+                    sim.Frame(timestep, frame.input, frame.frameTime);
+                }
+            } else {
+                CS381_PROFILE_ZONE("Simulation");
+                const InputSnapshot input = SampleInput();
+                recorder.Record(dt, input);
+                sim.Frame(timestep, input, dt);
+            }
+            AttachModels(sim);
 
             camera.BeginMode();
-
-            sky.Draw();
-            grass.Draw({});
-            RenderSystem();
-
+            {
+                CS381_PROFILE_ZONE("SkyBox::Draw");
+                sky.Draw();
+            }
+            {
+                CS381_PROFILE_ZONE("RenderSystem");
+                grass.Draw({});
+                RenderSystem(sim, timestep.Alpha(), debug);
+            }
+            {
+                CS381_PROFILE_ZONE("DebugDraw");
+                debug.Flush();
+            }
             camera.EndMode();
-            DrawUI();
+
+            CS381_PROFILE_ZONE("UI");
+            DrawUI(sim);
             ChatSystem();
+            if (showProfiler) DrawProfiler();
+            if (replayPath) {
+                const char* status = replay.Done() ? "Replay finished" : TextFormat("Replay %zu/%zu (x%.2f)", replay.next, replay.frames.size(), replaySpeed);
+                DrawText(status, SCREEN_WIDTH - MeasureText(status, 20) - 20, 20, 20, DARKGRAY);
+            }
         }
 
-        window.EndDrawing();
+        {
+            CS381_PROFILE_ZONE("EndDrawing");  // Buffer swap, plus waiting for the target frame rate
+            window.EndDrawing();
+        }
+        profiler.EndFrame();
     }
 
     UnloadMusicStream(ambientMusic);
@@ -0,0 +1,133 @@
+// Checks the parts of the ECS scene (ECS.hpp) the game doesn't exercise: reserving entity IDs from several threads at
+// once (then backing them with SyncEntities and giving them components on the main thread), and migrating entities with
+// plain and split components from one scene to another
+// Exits with a non zero status if any check fails, run by ctest (or by hand as as9_ecs_test)
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "ECS.hpp"
+
+size_t globalComponentCounter = 0;
+
+using namespace cs381;
+
+static int failures = 0;
+
+static void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::cerr << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+struct Tag {
+    Entity self;
+};
+
+struct Body {
+    float mass;
+    int flags;
+};
+
+template<>
+struct cs381::SplitComponent<Body> {
+    static constexpr auto fields = std::make_tuple(&Body::mass, &Body::flags);
+};
+
+// Threads reserve IDs concurrently (with the main thread creating entities meanwhile), every ID must be handed out once
+static void ReserveFromThreads() {
+    constexpr int threadCount = 8, perThread = 1000;  // Not a multiple of the batch size, so batches are left part used
+    Scene<> scene;
+    Entity first = scene.CreateEntity();
+
+    std::vector<std::vector<Entity>> reserved(threadCount);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+        threads.emplace_back([&scene, &reserved, t] {
+            for (int i = 0; i < perThread; ++i) reserved[t].push_back(scene.ReserveEntity());
+        });
+    std::vector<Entity> created;
+    for (int i = 0; i < 100; ++i) created.push_back(scene.CreateEntity());
+    for (auto& thread : threads) thread.join();
+
+    std::vector<Entity> all = { first };
+    all.insert(all.end(), created.begin(), created.end());
+    for (auto& ids : reserved) all.insert(all.end(), ids.begin(), ids.end());
+    std::sort(all.begin(), all.end());
+    Check(std::adjacent_find(all.begin(), all.end()) == all.end(), "reserved and created IDs are unique");
+
+    scene.SyncEntities();
+    Check(scene.entityMasks.size() > all.back(), "SyncEntities backs every reserved ID");
+
+    for (auto& ids : reserved)
+        for (Entity e : ids) {
+            scene.AddComponent<Tag>(e).self = e;
+            scene.AddComponent<Body>(e) = Body{ (float)e, (int)e * 2 };
+        }
+    bool intact = true;
+    for (auto& ids : reserved)
+        for (Entity e : ids) {
+            Body body = scene.GetComponent<Body>(e);
+            intact &= scene.GetComponent<Tag>(e).self == e && body.mass == (float)e && body.flags == (int)e * 2;
+        }
+    Check(intact, "components added to reserved IDs read back");
+
+    size_t tagged = 0;
+    for (auto [tag] : scene.View<Tag>()) {
+        (void)tag;
+        ++tagged;
+    }
+    Check(tagged == threadCount * perThread, "views see exactly the reserved entities with components");
+
+    // A thread's cached batch belongs to one scene, reserving from another scene must not reuse it
+    Scene<> other;
+    Entity mine = scene.ReserveEntity(), theirs = other.ReserveEntity();
+    Check(std::find(all.begin(), all.end(), mine) == all.end(), "a later reservation gets a fresh ID");
+    Check(theirs == 0, "another scene's reservations start at its own first ID");
+}
+
+// Entities move with all of their components, keep their values under new IDs and leave empty entities behind
+static void MigrateBetweenScenes() {
+    Scene<> source, destination;
+    destination.CreateEntities(3);  // So new IDs differ from the old ones
+    std::vector<Entity> entities = source.CreateEntities(6);
+
+    for (Entity e : entities) {
+        if (e % 2 == 0) source.AddComponent<Tag>(e).self = e;  // Only some have a Tag, so not every storage moves for every entity
+        source.AddComponent<Body>(e) = Body{ e * 1.5f, (int)e };
+    }
+    std::vector<Entity> moving = { entities[4], entities[1], entities[2] };  // Out of order
+    std::vector<Entity> moved = source.MigrateEntities(moving, destination);
+
+    Check(moved == std::vector<Entity>{ 3, 4, 5 }, "migrated entities get consecutive new IDs in the order given");
+    bool values = true;
+    for (size_t i = 0; i < moving.size(); ++i) {
+        Entity old = moving[i], e = moved[i];
+        Body body = destination.GetComponent<Body>(e);
+        values &= body.mass == old * 1.5f && body.flags == (int)old;
+        values &= destination.HasComponent<Tag>(e) == (old % 2 == 0);
+        if (old % 2 == 0) values &= destination.GetComponent<Tag>(e).self == old;  // Bytes are copied as is
+    }
+    Check(values, "plain and split component values are copied");
+
+    bool emptied = true;
+    for (Entity old : moving) emptied &= !source.HasComponent<Tag>(old) && !source.HasComponent<Body>(old);
+    Check(emptied, "migrated source entities are left empty");
+    Body stayed = source.GetComponent<Body>(entities[3]);
+    Check(stayed.mass == entities[3] * 1.5f && source.GetComponent<Tag>(entities[0]).self == entities[0], "entities which didn't move keep their components");
+
+    size_t sourceBodies = 0, destinationBodies = 0;
+    for (auto [body] : source.View<Body>()) { (void)body; ++sourceBodies; }
+    for (auto [body] : destination.View<Body>()) { (void)body; ++destinationBodies; }
+    Check(sourceBodies == 3 && destinationBodies == 3, "views follow the migrated entities");
+}
+
+int main() {
+    ReserveFromThreads();
+    MigrateBetweenScenes();
+
+    if (failures == 0) std::cout << "all ECS checks passed\n";
+    return failures == 0 ? 0 : 1;
+}
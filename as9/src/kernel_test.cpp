@@ -0,0 +1,100 @@
+// Checks the batch kernels (SimdKernels.hpp): the kernels dispatched on this CPU (AVX2, NEON or scalar) must match the
+// scalar reference bit for bit, and sinCos must stay inside its documented error bound
+// Exits with a non zero status on the first kind of failure found, run by ctest (or by hand as as9_kernel_test)
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "SimdKernels.hpp"
+
+using namespace cs381;
+
+static int failures = 0;
+
+static void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::cerr << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+static bool SameBits(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+static std::vector<float> Uniform(std::mt19937& random, size_t count, float low, float high) {
+    std::uniform_real_distribution<float> distribution(low, high);
+    std::vector<float> out(count);
+    for (float& x : out) x = distribution(random);
+    return out;
+}
+
+int main() {
+    const simd::Kernels& scalar = simd::ScalarKernels();
+    const simd::Kernels& active = simd::ActiveKernels();
+    std::cout << "kernels: " << active.name << "\n";
+    std::mt19937 random(381);
+
+    // Odd lengths so the vector loops and their scalar tails both run
+    for (size_t count : { 0, 1, 3, 7, 8, 9, 17, 1001 }) {
+        std::vector<float> radians = Uniform(random, count, -8192.0f, 8192.0f);
+        std::vector<float> sines(count), cosines(count), scalarSines(count), scalarCosines(count);
+        active.sinCos(radians, sines, cosines);
+        scalar.sinCos(radians, scalarSines, scalarCosines);
+        Check(SameBits(sines, scalarSines) && SameBits(cosines, scalarCosines), "sinCos matches the scalar kernel");
+
+        std::vector<float> headings = Uniform(random, count, -1e6f, 1e6f);
+        std::vector<float> speeds = Uniform(random, count, -20.0f, 20.0f);
+        std::vector<float> velocities(count * 3), scalarVelocities(count * 3);
+        active.headingToVelocity(headings, speeds, velocities);
+        scalar.headingToVelocity(headings, speeds, scalarVelocities);
+        Check(SameBits(velocities, scalarVelocities), "headingToVelocity matches the scalar kernel");
+
+        std::vector<float> positions = Uniform(random, count * 3, -500.0f, 500.0f);
+        std::vector<float> moved(count * 3), scalarMoved(count * 3);
+        active.integrate(moved, positions, velocities, 1.0f / 60.0f);
+        scalar.integrate(scalarMoved, positions, velocities, 1.0f / 60.0f);
+        Check(SameBits(moved, scalarMoved), "integrate matches the scalar kernel");
+        active.integrate(positions, positions, velocities, 1.0f / 60.0f);  // In place
+        Check(SameBits(positions, scalarMoved), "integrate works in place");
+    }
+
+    // Error bound: below 2e-7 for |x| <= 8192, checked on the dispatched path against double precision
+    // Every octant boundary of the first turns, then a dense random sample of the whole range
+    std::vector<float> radians;
+    for (int k = -64; k <= 64; ++k)
+        for (float x : { k * 0.78539816339744831f, k * 1.5707963267948966f })
+            radians.insert(radians.end(), { std::nextafter(x, -1e9f), x, std::nextafter(x, 1e9f) });
+    radians.insert(radians.end(), { 0.0f, -0.0f, 8192.0f, -8192.0f, 1e-30f });
+    std::vector<float> sampled = Uniform(random, 1 << 20, -8192.0f, 8192.0f);
+    radians.insert(radians.end(), sampled.begin(), sampled.end());
+
+    std::vector<float> sines(radians.size()), cosines(radians.size());
+    simd::SinCos(radians, sines, cosines);
+    double worst = 0;
+    for (size_t i = 0; i < radians.size(); ++i) {
+        worst = std::max(worst, std::abs(sines[i] - std::sin((double)radians[i])));
+        worst = std::max(worst, std::abs(cosines[i] - std::cos((double)radians[i])));
+    }
+    std::cout << "sinCos worst absolute error: " << worst << "\n";
+    Check(worst < 2e-7, "sinCos stays below 2e-7 for |x| <= 8192");
+
+    // Headings are wrapped exactly up to the documented magnitude, so the velocity only carries sinCos' error
+    std::vector<float> headings = Uniform(random, 1 << 16, -1e8f, 1e8f);
+    std::vector<float> speeds(headings.size(), 1.0f), velocities(headings.size() * 3);
+    simd::HeadingToVelocity(headings, speeds, velocities);
+    double worstVelocity = 0;
+    for (size_t i = 0; i < headings.size(); ++i) {
+        double h = std::remainder((double)headings[i], 360.0) * 3.14159265358979323846 / 180.0;
+        worstVelocity = std::max(worstVelocity, std::abs(velocities[i * 3 + 0] - std::cos(h)));
+        worstVelocity = std::max(worstVelocity, std::abs(velocities[i * 3 + 2] + std::sin(h)));
+    }
+    std::cout << "headingToVelocity worst absolute error: " << worstVelocity << "\n";
+    Check(worstVelocity < 1e-6, "headingToVelocity is accurate for |heading| <= 1e8");
+
+    if (failures == 0) std::cout << "all kernel checks passed\n";
+    return failures == 0 ? 0 : 1;
+}
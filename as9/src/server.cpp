@@ -0,0 +1,174 @@
+// Headless Conenado: runs the game rules as fast as possible, with no window, GPU or audio
+// Input comes from a script file or from a built in bot which chases the goal, then the tick rate is reported
+//
+// Usage: as9_server [--ticks N] [--cones N] [--seed N] [--workers N] [--script file] [--record file] [--replay file]
+//                  [--profile file]
+// Script files hold one "<ticks> <keys>" pair per line, keys is any of WSAD (held for those ticks) and T (TAB,
+// pressed on the first of those ticks) or - for no keys. The script loops until --ticks have run
+// --record saves the session as a replay (see Replay.hpp), --replay plays one back (recorded here or by the game, the
+// seed, cones and tick count then come from the file) and the final state hash shows whether two runs matched
+// --profile writes the last frames' zones (per system, per worker thread) as a Chrome trace, see Profiler.hpp
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Profiler.hpp"
+#include "Replay.hpp"
+#include "Simulation.hpp"
+#include "SimdKernels.hpp"
+
+struct ScriptStep {
+    int ticks;
+    InputSnapshot input;
+};
+
+std::vector<ScriptStep> LoadScript(const char* path) {
+    std::vector<ScriptStep> script;
+    std::ifstream file(path);
+    int ticks;
+    std::string keys;
+    while (file >> ticks >> keys) {
+        InputSnapshot input;
+        input.accelerate = keys.find_first_of("Ww") != std::string::npos;
+        input.decelerate = keys.find_first_of("Ss") != std::string::npos;
+        input.turnLeft = keys.find_first_of("Aa") != std::string::npos;
+        input.turnRight = keys.find_first_of("Dd") != std::string::npos;
+        input.selectNext = keys.find_first_of("Tt") != std::string::npos;
+        if (ticks > 0) script.push_back({ ticks, input });
+    }
+    return script;
+}
+
+// Steer the selected car towards the goal
+InputSnapshot Bot(cs381::Simulation& sim) {
+    EntityID car = sim.Selected();
+    Vector3 carPos = sim.world.GetField<&TransformComponent::position>(car);
+    Vector3 goalPos = sim.world.GetField<&TransformComponent::position>(sim.goalEntity);
+    float heading = sim.world.GetField<&Physics2DComponent::heading>(car);
+
+    float desired = atan2f(-(goalPos.z - carPos.z), goalPos.x - carPos.x) * RAD2DEG;  // Cars drive along (cos, 0, -sin) of their heading
+    float diff = remainderf(desired - heading, 360.0f);
+
+    InputSnapshot input;
+    input.turnLeft = diff > 2;
+    input.turnRight = diff < -2;
+    input.accelerate = fabsf(diff) < 60;
+    input.decelerate = !input.accelerate && sim.world.GetField<&VelocityComponent::speed>(car) > 2;
+    return input;
+}
+
+int main(int argc, char** argv) {
+    uint64_t ticks = 60 * 60;
+    int cones = 1;
+    uint64_t seed = 0;
+    size_t workers = 3;
+    const char* scriptPath = nullptr;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* profilePath = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--ticks") && hasValue) ticks = std::strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--cones") && hasValue) cones = std::max(std::atoi(argv[++i]), 1);
+        else if (!strcmp(argv[i], "--seed") && hasValue) seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--workers") && hasValue) workers = std::max(std::atoi(argv[++i]), 1);
+        else if (!strcmp(argv[i], "--script") && hasValue) scriptPath = argv[++i];
+        else if (!strcmp(argv[i], "--record") && hasValue) recordPath = argv[++i];
+        else if (!strcmp(argv[i], "--replay") && hasValue) replayPath = argv[++i];
+        else if (!strcmp(argv[i], "--profile") && hasValue) profilePath = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--ticks N] [--cones N] [--seed N] [--workers N] [--script file] [--record file] [--replay file] [--profile file]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<ScriptStep> script;
+    if (scriptPath) {
+        script = LoadScript(scriptPath);
+        if (script.empty()) {
+            std::cerr << "Script " << scriptPath << " has no steps" << std::endl;
+            return 1;
+        }
+    }
+
+    cs381::InputReplay replay;
+    if (replayPath) {
+        if (!replay.Load(replayPath)) {
+            std::cerr << "Couldn't load replay " << replayPath << std::endl;
+            return 1;
+        }
+        seed = replay.header.seed;
+        cones = std::max<int>(replay.header.cars, 1);
+    }
+
+    cs381::FixedTimestep timestep(replayPath ? replay.header.tickRate : 60.0f);
+    const float step = timestep.StepSize();
+
+    cs381::InputRecorder recorder;
+    if (recordPath && !recorder.Open(recordPath, { seed, (uint32_t)cones, timestep.tickRate })) {
+        std::cerr << "Couldn't write replay " << recordPath << std::endl;
+        return 1;
+    }
+
+    auto& profiler = cs381::Profiler::Instance();
+    profiler.SetThreadName("Main");
+    profiler.SetEnabled(profilePath != nullptr);
+
+    cs381::Simulation sim(seed, workers);
+    sim.SpawnGame(cones);
+
+    size_t scriptIndex = 0;
+    int scriptTick = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (replayPath ? !replay.Done() : sim.Ticks() < ticks) {
+        profiler.BeginFrame();
+        if (replayPath) {  // Replays go frame by frame exactly as recorded, however many ticks each frame ran
+            const cs381::ReplayFrame& frame = replay.Next();
+            recorder.Record(frame.frameTime, frame.input);
+            sim.Frame(timestep, frame.input, frame.frameTime);
+            profiler.EndFrame();
+            continue;
+        }
+
+        InputSnapshot input;
+        if (script.empty()) input = Bot(sim);
+        else {
+            input = script[scriptIndex].input;
+            input.selectNext = input.selectNext && scriptTick == 0;  // TAB is a press, not a hold
+            if (++scriptTick == script[scriptIndex].ticks) {
+                scriptTick = 0;
+                scriptIndex = (scriptIndex + 1) % script.size();
+            }
+        }
+
+        recorder.Record(step, input);  // Each server frame is exactly one tick
+        sim.Frame(timestep, input, step);
+        profiler.EndFrame();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "entities:       " << sim.world.entityMasks.size() << "\n"
+              << "ticks:          " << sim.Ticks() << " (" << sim.Ticks() * step << "s of game time)\n"
+              << "wall time:      " << elapsed.count() << "s\n"
+              << "ticks/second:   " << sim.Ticks() / std::max(elapsed.count(), 1e-9) << "\n"
+              << "score:          " << sim.score << "\n"
+              << "state hash:     " << std::hex << sim.StateHash() << std::dec << "\n"
+              << "workers:        " << workers << "\n"
+              << "kernels:        " << cs381::simd::ActiveKernels().name << std::endl;
+
+    if (profilePath) {
+        if (!profiler.ExportChromeTrace(profilePath)) {
+            std::cerr << "Couldn't write profile " << profilePath << std::endl;
+            return 1;
+        }
+        std::cout << "profile:        last " << profiler.FrameCount() << " frames in " << profilePath << std::endl;
+    }
+    return 0;
+}